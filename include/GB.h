@@ -2,9 +2,11 @@
 #include "GB_CPU.h"
 #include "GB_MEM.h"
 #include "GB_GPU.h"
+#include "GB_SCHEDULER.h"
+#include "GB_INPUT.h"
 #include "GB_CONST.h"
-#include "SDL.h"
 #include <string>
+#include <vector>
 #include <iostream>
 #include <exception>
 #include <iomanip>
@@ -13,21 +15,81 @@
 #include <memory>
 #include <chrono>
 #include <cmath>
+#include <algorithm>
+#include <functional>
 
 class GB {
 	public:
-        //Memory shared between cpu and gpu
-        std::shared_ptr<GB_MEM> mem = std::make_shared<GB_MEM>();
-        GB_CPU cpu;
-        GB_GPU gpu;
+        //Memory shared between cpu and gpu, which keep a reference to it
+        //Value initialized, so it starts zeroed
+        GB_MEM mem{};
+        GB_CPU cpu{mem};
+        GB_GPU gpu{mem};
+        GB_SCHEDULER scheduler;
 
-        //SDL variables
+        //Frame boundaries reached since power on
+        uint64_t frames = 0;
+
+        //Stops execute() at the next event
         bool quit = false;
-        SDL_Event e;
-        const int SCREEN_FPS = 60;
-        const int SCREEN_TICKS_PER_FRAME = 1000 / SCREEN_FPS;
 
-		GB(std::string fileName);
+        //Called at every frame boundary, a frontend paces the emulation and handles its window here
+        std::function<void()> frameHandler;
+
+        //Polled once per frame for the buttons to pass to GB_MEM::handleButton, nothing is pressed without one
+        GB_INPUT* input = nullptr;
+
+        //Set once the rom passed to the constructor was accepted by GB_MEM::loadRom, the machine must not run otherwise
+        bool loaded = false;
+
+		GB(std::string fileName, bool loadSave = true);
+
+        GB(std::vector<unsigned char> rom, bool loadSave = true);
 
+        //cpu and gpu reference mem and the scheduler handlers capture this, so a machine can't be copied or moved
+        GB(const GB&) = delete;
+        GB& operator=(const GB&) = delete;
+        GB(GB&&) = delete;
+        GB& operator=(GB&&) = delete;
+
+        //Runs until quit is set or the cpu stops
         void execute();
+
+        //Runs until the next frame boundary, returns false if the cpu stopped
+        bool runFrame();
+
+        //Last frame drawn by the gpu, 144 rows of 160 pixels of 4 bytes (see GB_GPU::screen)
+        const uint8_t* framebuffer() const;
+
+        //Snapshot of the whole machine, see GB_STATE.h for the format
+        //Only valid between runFrame calls, not from inside a handler
+        //state is overwritten and keeps its capacity, so saving into the same vector again doesn't allocate
+        void saveState(std::vector<uint8_t>& state);
+
+        //Returns false and leaves the machine untouched if the state is damaged, of another version or of another rom
+        bool loadState(const std::vector<uint8_t>& state);
+
+        bool saveStateFile(const std::string& fileName);
+
+        bool loadStateFile(const std::string& fileName);
+
+        void serialize(GB_STATE& state);
+
+        //Time the gpu and timers have been brought up to
+        uint64_t gpuSyncedTo = 0;
+        uint64_t timersSyncedTo = 0;
+
+        //Brings the gpu and timers up to time and has their next events recomputed once the current instruction ends
+        void syncComponents(uint64_t time);
+
+        void syncGPU(uint64_t time);
+
+        void syncTimers(uint64_t time);
+
+    private:
+        //Wires the components together and sets the state left by the boot rom
+        void powerOn();
+
+        //Runs the cpu until the next event and handles every event that is due, returns false if the cpu stopped
+        bool step();
 };
\ No newline at end of file
@@ -31,6 +31,13 @@
 #define LYC 0xFF45
 #define WY 0xFF4A
 #define WX 0xFF4B
+#define TILE_DATA_BEGIN 0x8000
+#define TILE_DATA_END 0x97FF
+#define TILE_COUNT 384
+#define OAM_BEGIN 0xFE00
+#define OAM_END 0xFE9F
+#define SPRITE_COUNT 40
+#define SPRITES_PER_LINE 10
 #define IF 0xFF0F
 #define IE 0xFFFF
 #define MODE_2_CYCLES 80
@@ -1,41 +1,84 @@
 #pragma once
-#include "SDL.h"
 #include "GB_CONST.h"
 #include "GB_MEM.h"
+#include "GB_PIXELS.h"
+#include "GB_STATE.h"
 #include <stdio.h>
+#include <cstring>
 #include <chrono>
 #include <vector>
 #include <algorithm>
 #include <memory>
-
-struct sprite
-{
-    uint8_t xPos;
-    uint8_t yPos;
-    uint8_t tileLocation;
-    uint8_t attributes;
-};
+#include <functional>
 
 class GB_GPU {
     public:
-        //std::shared_ptr<std::array<uint8_t,0xFFFF>> memory;
-        std::shared_ptr<GB_MEM> memory;
+        //Owned by GB
+        GB_MEM& memory;
 
         unsigned int currentCycle = 0;
-        uint8_t scale = 3;
-        SDL_Window* window = nullptr;
-        SDL_Surface* screenSurface = nullptr;
-        SDL_Surface* gameSurface = nullptr;
-        uint8_t* pixels = nullptr;
-        uint8_t screen[144][160][4];
+        //Blue, green, red and the background color number of every pixel
+        uint8_t screen[144][160][4] = {};
+
+        //Hash of every line of screen, taken when the line is drawn or a state is loaded
+        uint64_t lineHashes[144] = {};
+
+        //Lines whose hash changed since clearDirtyLines(), and whether any did
+        //Consumers of screen can skip a frame that didn't change, or handle only the lines that did
+        bool dirtyLines[144] = {};
+        bool screenChanged = false;
+
+        //Called when a whole frame has been drawn into screen, at the start of vblank
+        std::function<void()> frameHandler;
+
+        //Lines aren't drawn and frameHandler isn't called, LY, STAT and the interrupts keep their timing
+        bool skipRendering = false;
+
+        //Frames skipped the same way after every drawn one, for fast forward
+        //Decided when line 0 starts, so a frame is always drawn whole or not at all
+        int frameSkip = 0;
 
-        GB_GPU();
+        //Colors of the four shades, lightest first, as 0xRRGGBB
+        //One set for the background and window, then one for each sprite palette
+        uint32_t theme[3][4] = {
+            {0xFFFFFF, 0xCCCCCC, 0x777777, 0x000000},
+            {0xFFFFFF, 0xCCCCCC, 0x777777, 0x000000},
+            {0xFFFFFF, 0xCCCCCC, 0x777777, 0x000000}
+        };
+
+        //Screen pixel of each color number through BGP, OBP0 and OBP1, rebuilt when GB_MEM marks them dirty
+        //The background's carry the color number in their fourth byte
+        uint32_t palettes[3][4];
+
+        //Color number of every pixel of the 384 tiles in VRAM, decoded again when GB_MEM marks one dirty
+        //Not part of a state, all tiles are marked dirty when one is loaded
+        uint8_t tiles[TILE_COUNT][8][8] = {};
+
+        //Optional second destination of every drawn line, such as a locked streaming texture
+        //Rows are outputPitch bytes apart and pixels have the byte order of screen
+        uint8_t* output = nullptr;
+        int outputPitch = 0;
+
+        //Count of lines written to output in order from line 0 since it was set, -1 once a line was missed or a state was loaded
+        //144 when frameHandler is called means output holds the whole frame
+        int outputLines = 0;
 
         bool hblank = false;
         bool oam = false;
         bool vblank = false;
 
-        void update(short cycles);
+        GB_GPU(GB_MEM& memory);
+
+        void update(int cycles);
+
+        //Cycles until update would change any state, assuming no LCD register is written meanwhile
+        int cyclesUntilNextEvent();
+
+        //Sets output, or clears it with nullptr
+        void setOutput(uint8_t* pixels, int pitch);
+
+        //Draws the background, window and sprites of a line into screen and output
+        void drawLine(uint16_t line);
 
         void drawTiles(uint16_t line);
 
@@ -43,8 +86,31 @@ class GB_GPU {
 
         uint8_t getColor(int colorNum, uint16_t address);
 
-        void drawArrayToSurface();
+        //Changes the colors of every palette, or of one of them, taking effect from the next line drawn
+        void setTheme(const uint32_t colors[4]);
+        void setTheme(int palette, const uint32_t colors[4]);
+
+        //Returns the decoded row of a tile, decoding the tile first if it is dirty
+        const uint8_t* tileRow(int tile, int row);
+
+        void clearDirtyLines();
+
+        //Hash of the whole screen made from the line hashes, equal screens hash the same
+        uint64_t frameHash();
+
+        void serialize(GB_STATE& state);
 
     private:
-        static bool spriteSort(const sprite& lhs, const sprite& rhs);
+        //Frames since the last one drawn for frameSkip, and whether the current one is skipped
+        int framesSkipped = 0;
+        bool skipFrame = false;
+
+        //Bytes of a pixel in screen as one value in host byte order
+        static uint32_t packPixel(uint32_t color, uint8_t colorNum);
+
+        void updatePalettes();
+
+        //Rehashes a line of screen and marks it dirty if it changed
+        void hashLine(int line);
+
 };
\ No newline at end of file
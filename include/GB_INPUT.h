@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+//Source of the buttons held each frame, polled by GB once per frame
+class GB_INPUT {
+    public:
+        virtual ~GB_INPUT() = default;
+
+        //Buttons held during frame (GB::frames when polled), see GB_MEM::handleButton for the bits
+        virtual uint8_t poll(uint64_t frame) = 0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include "GB_MEM.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+class GB_CPU;
+
+//Translates hot straight-line blocks of guest code into x86-64
+//Blocks stop before any instruction that writes memory, touches I/O or changes interrupt state,
+//so no component event or code invalidation can happen while one is running
+class GB_JIT {
+    public:
+        struct block {
+            void (*code)(GB_CPU*) = nullptr; //nullptr if the first instruction must be interpreted
+            uint16_t cycles = 0; //Cycles of all instructions, not counting taken branches, added to batchCycles by the block itself
+            uint16_t cyclesBeforeLast = 0;
+            uint8_t instructions = 0;
+            uint8_t bank = 0;
+            bool inRAM = false;
+            uint8_t page = 0;
+            unsigned int generation = 0;
+        };
+
+        GB_JIT(GB_CPU* cpu, GB_MEM& memory);
+        ~GB_JIT();
+
+        //Returns the block starting at pc, translating it once it is hot
+        //Returns nullptr while the address is still cold
+        block* find(uint16_t pc);
+
+    private:
+        static const int HOT_THRESHOLD = 16;
+        static const int MAX_BLOCK_INSTRUCTIONS = 64;
+        static const size_t CODE_SIZE = 4 * 1024 * 1024;
+        static const size_t MAX_BLOCK_BYTES = MAX_BLOCK_INSTRUCTIONS * 32 + 16;
+
+        enum opClass {
+            FALLBACK, //Left to the interpreter, ends the block before it
+            NATIVE, //Emitted inline
+            CALL, //Emitted as a call to the interpreter handler
+            TERMINAL //Emitted as a call, ends the block after it
+        };
+
+        GB_CPU* cpu;
+        GB_MEM& memory;
+
+        uint8_t* code = nullptr;
+        size_t codeUsed = 0;
+        uint8_t* cursor = nullptr;
+
+        std::unordered_map<uint32_t, block> blocks;
+        block* cache[0x10000] = {};
+        uint8_t heat[0x10000] = {};
+
+        //Offsets of the cpu registers from the GB_CPU pointer held in rbx
+        int32_t r8Offset[8];
+        int32_t r16Offset[4];
+        int32_t pcOffset;
+        int32_t batchCyclesOffset;
+
+        uint8_t bankFor(uint16_t pc);
+        bool isValid(const block& b, uint16_t pc);
+        block translate(uint16_t pc);
+        opClass classify(uint16_t pc, uint8_t op);
+        uint8_t length(uint8_t op);
+        void flush();
+
+        void emit8(uint8_t value);
+        void emit16(uint16_t value);
+        void emit32(uint32_t value);
+        void emit64(uint64_t value);
+        void emitNative(uint16_t pc, uint8_t op);
+        void emitCall(uint8_t op);
+        void emitAddCycles(int32_t cycles);
+        void emitSetPC(uint16_t pc);
+};
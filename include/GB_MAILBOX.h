@@ -0,0 +1,33 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+//Hands finished frames from the emulation thread to a display thread without locks
+//
+//Three buffers: the writer owns one to draw into, the reader owns one to show, and the third
+//holds the newest published frame. Publishing and taking swap a buffer with that third one
+//atomically, so neither side ever waits for the other. Frames the reader doesn't take in time are
+//replaced by newer ones, the reader always gets the newest.
+//There must be one writer thread and one reader thread.
+class GB_MAILBOX {
+    public:
+        typedef uint8_t frame[144][160][4];
+
+        //Buffer the writer draws the next frame into, changes with every publish()
+        frame& back();
+
+        //Makes back() the newest frame and hands the writer another buffer
+        void publish();
+
+        //Returns the newest frame published since the last call, nullptr if there is none
+        //The frame stays valid until the next call
+        const frame* take();
+
+    private:
+        static const uint8_t FRESH = 0x4; //Set in middle when it holds a frame the reader hasn't taken
+
+        frame frames[3] = {};
+        std::atomic<uint8_t> middle{1};
+        uint8_t writing = 0;
+        uint8_t reading = 2;
+};
@@ -1,11 +1,22 @@
 #pragma once
 #include "GB_CONST.h"
+#include "GB_STATE.h"
 #include <fstream>
 #include <string>
 #include <iostream>
 #include <vector>
-#include "SDL.h"
 #include <cmath>
+#include <algorithm>
+#include <functional>
+
+//An OAM entry with its position in screen pixels
+struct sprite
+{
+    int16_t xPos; //Leftmost column, OAM x - 8
+    int16_t yPos; //Top line, OAM y - 16
+    uint8_t tileLocation;
+    uint8_t attributes;
+};
 
 class GB_MEM {
 	public:
@@ -29,6 +40,57 @@ class GB_MEM {
         const int TIM_11_CYCLES = 256;
         int elapsedTimerCycles = 0;
         int elapsedDividerCycles = 0;
+
+        //Set when a timer or LCD register is written, so a batch of instructions ends before the next one
+        bool syncRequested = false;
+
+        //Called before a timer or LCD register changes or DIV is read, to bring those components up to date
+        std::function<void()> syncHandler;
+
+        //Direct pointers to each 256 byte page of the address space
+        //nullptr pages are banked registers, I/O or otherwise need the full address decode
+        unsigned char* readPages[0x100] = {};
+        unsigned char* writePages[0x100] = {};
+
+        //Set for every tile whose 16 bytes of tile data changed since the gpu last decoded it
+        //Tile data pages take the slow path so these writes can be caught
+        bool tileDirty[TILE_COUNT];
+
+        void markTilesDirty();
+
+        //Set when BGP, OBP0 or OBP1 is written, cleared once the gpu has rebuilt its palettes
+        bool paletteDirty = true;
+
+        //OAM as parsed entries, kept up to date by OAM writes and DMA
+        sprite sprites[SPRITE_COUNT];
+
+        //Parses the OAM entry holding address, or every entry
+        void parseSprite(unsigned short index);
+        void parseSprites();
+
+#ifdef GGBOY_JIT
+        //Pages of RAM holding translated code, and a counter bumped whenever one of them is written
+        //Writes to these pages take the slow path so they can be caught
+        bool codePages[0x100] = {};
+        unsigned int codeGeneration[0x100] = {};
+
+        void protectCode(unsigned short index);
+#endif
+
+        //Drops translated code on the page of a written RAM address
+#ifdef GGBOY_JIT
+        void invalidateCode(unsigned short index)
+        {
+            if(codePages[index >> 8])
+            {
+                codePages[index >> 8] = false;
+                codeGeneration[index >> 8]++;
+                updatePageTables();
+            }
+        }
+#else
+        void invalidateCode(unsigned short) {}
+#endif
         
         enum buttons
         {
@@ -43,11 +105,40 @@ class GB_MEM {
         };
         unsigned char pressedButtons = 0xFF;
 
-		void loadRom(std::string &fileName);
+        //Returns false if the file can't be read or isn't a rom, see the other overload
+		bool loadRom(std::string &fileName, bool loadSave = true);
 
-		unsigned char read(unsigned short index);
+        //Rom image already in memory, returns false if it's shorter than 0x8000 bytes or its header checksum is wrong
+        //Without loadSave the battery ram of the cartridge is neither read from nor written to <title>.sav
+        bool loadRom(std::vector<unsigned char> rom, bool loadSave = true);
 
-		void write(unsigned short index, unsigned char value);
+		unsigned char read(unsigned short index)
+        {
+            unsigned char* page = readPages[index >> 8];
+            if(page != nullptr)
+                return page[index & 0xFF];
+            return readSlow(index);
+        }
+
+		void write(unsigned short index, unsigned char value)
+        {
+            unsigned char* page = writePages[index >> 8];
+            if(page != nullptr)
+                page[index & 0xFF] = value;
+            else
+                writeSlow(index, value);
+        }
+
+        unsigned char readSlow(unsigned short index);
+
+        void writeSlow(unsigned short index, unsigned char value);
+
+        //Points every page at its current bank
+        void updatePageTables();
+
+        //Remap only the switchable ROM or external RAM pages after a bank change
+        void mapROMBank();
+        void mapRAMBank();
 
         void handleBanking(unsigned short index, unsigned char value);
 
@@ -61,12 +152,24 @@ class GB_MEM {
 
         void changeROMRAMMode(unsigned char data);
 
-        void handleButton(const unsigned char * keys);
+        //pressed has the bit of every held button set, directions in the low nibble and the others in the high one
+        void handleButton(unsigned char pressed);
+
+        void requestSync();
 
         void updateTimers(int cycles);
 
+        //Cycles until updateTimers would change TIMA, or DIV wrap around while the timer is stopped
+        //DIV has no event of its own, it is caught up whenever it is read
+        int cyclesUntilTimerEvent();
+
+        int timerPeriod();
+
         void save();
 
+        //Rom and cartridge type aren't part of a state, they come from the loaded rom
+        void serialize(GB_STATE& state);
+
         unsigned char copy = 0;
 
         unsigned char& operator[](int index);
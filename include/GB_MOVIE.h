@@ -0,0 +1,57 @@
+#pragma once
+#include "GB_INPUT.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Buttons held on each frame of a run, enough to replay it exactly from the same starting state
+//
+//File format, fields in host byte order:
+//  magic "GGBM", format version, rom id (GB_STATE::romId), first frame
+//  then one button mask byte per frame
+class GB_MOVIE {
+    public:
+        static const uint32_t MAGIC = 0x4D424747;
+        static const uint32_t VERSION = 1;
+
+        uint32_t rom = 0;
+
+        //Frame of the first mask, 1 for a movie starting at power on
+        uint64_t startFrame = 1;
+
+        std::vector<uint8_t> buttons;
+
+        //Frame after the last recorded one
+        uint64_t endFrame();
+
+        bool save(const std::string& fileName);
+
+        //Returns false if the file is missing, truncated or of another version
+        bool load(const std::string& fileName);
+};
+
+//Passes another source through and records it
+//Polling a frame again, after a rewind or a run ahead, drops what was recorded from that frame on
+class GB_RECORDER : public GB_INPUT {
+    public:
+        GB_RECORDER(GB_INPUT* source, GB_MOVIE& movie);
+
+        uint8_t poll(uint64_t frame) override;
+
+    private:
+        GB_INPUT* source;
+        GB_MOVIE& movie;
+};
+
+//Replays a movie, nothing is pressed outside of it
+class GB_PLAYER : public GB_INPUT {
+    public:
+        GB_PLAYER(const GB_MOVIE& movie);
+
+        uint8_t poll(uint64_t frame) override;
+
+        bool finished(uint64_t frame);
+
+    private:
+        const GB_MOVIE& movie;
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+//Main opcode table, expanded by GB_CPU into its dispatch tables
+//X(opcode, disassembly, cycles, handler) - each handler is instantiated with its own opcode
+#define GB_OPCODES(X) \
+    X(0x00, "NOP", 4, nop) \
+    X(0x01, "LD BC,nn", 12, LDNnn) \
+    X(0x02, "LD (BC),A", 8, LDr1r2) \
+    X(0x03, "INC BC", 8, INC16) \
+    X(0x04, "INC B", 4, INC) \
+    X(0x05, "DEC B", 4, DEC) \
+    X(0x06, "LD B,n", 8, LDnnN) \
+    X(0x07, "RLCA", 4, CBA) \
+    X(0x08, "LD (nn),SP", 20, LDnnSP) \
+    X(0x09, "ADD HL,BC", 8, ADD16) \
+    X(0x0A, "LD A,(BC)", 8, LDr1r2) \
+    X(0x0B, "DEC BC", 8, DEC16) \
+    X(0x0C, "INC C", 4, INC) \
+    X(0x0D, "DEC C", 4, DEC) \
+    X(0x0E, "LD C,n", 8, LDnnN) \
+    X(0x0F, "RRCA", 4, CBA) \
+    X(0x10, "STOP", 4, STOP) \
+    X(0x11, "LD DE,nn", 12, LDNnn) \
+    X(0x12, "LD (DE),A", 8, LDr1r2) \
+    X(0x13, "INC DE", 8, INC16) \
+    X(0x14, "INC D", 4, INC) \
+    X(0x15, "DEC D", 4, DEC) \
+    X(0x16, "LD D,n", 8, LDnnN) \
+    X(0x17, "RLA", 4, CBA) \
+    X(0x18, "JR n", 8, JRccn) \
+    X(0x19, "ADD HL,DE", 8, ADD16) \
+    X(0x1A, "LD A,(DE)", 8, LDr1r2) \
+    X(0x1B, "DEC DE", 8, DEC16) \
+    X(0x1C, "INC E", 4, INC) \
+    X(0x1D, "DEC E", 4, DEC) \
+    X(0x1E, "LD E,n", 8, LDnnN) \
+    X(0x1F, "RRA", 4, CBA) \
+    X(0x20, "JR NZ,n", 8, JRccn) \
+    X(0x21, "LD HL,nn", 12, LDNnn) \
+    X(0x22, "LDI (HL),A", 8, LDI) \
+    X(0x23, "INC HL", 8, INC16) \
+    X(0x24, "INC H", 4, INC) \
+    X(0x25, "DEC H", 4, DEC) \
+    X(0x26, "LD H,n", 8, LDnnN) \
+    X(0x27, "DAA", 4, DAA) \
+    X(0x28, "JR Z,n", 8, JRccn) \
+    X(0x29, "ADD HL,HL", 8, ADD16) \
+    X(0x2A, "LDI A, (HL)", 8, LDI) \
+    X(0x2B, "DEC HL", 8, DEC16) \
+    X(0x2C, "INC L", 4, INC) \
+    X(0x2D, "DEC L", 4, DEC) \
+    X(0x2E, "LD L,n", 8, LDnnN) \
+    X(0x2F, "CPL", 4, cpl) \
+    X(0x30, "JR NC,n", 8, JRccn) \
+    X(0x31, "LD SP,nn", 12, LDNnn) \
+    X(0x32, "LDD (HL),A", 8, LDD) \
+    X(0x33, "INC SP", 8, INC16) \
+    X(0x34, "INC (HL)", 12, INC) \
+    X(0x35, "DEC (HL)", 12, DEC) \
+    X(0x36, "LD (HL),n", 12, LDr1r2) \
+    X(0x37, "SCF", 4, SCF) \
+    X(0x38, "JR C,n", 8, JRccn) \
+    X(0x39, "ADD HL,SP", 8, ADD16) \
+    X(0x3A, "LDD A,(HL)", 8, LDD) \
+    X(0x3B, "DEC SP", 8, DEC16) \
+    X(0x3C, "INC A", 4, INC) \
+    X(0x3D, "DEC A", 4, DEC) \
+    X(0x3E, "LD A,#", 8, LDr1r2) \
+    X(0x3F, "CCF", 4, CCF) \
+    X(0x40, "LD B,B", 4, LDr1r2) \
+    X(0x41, "LD B,C", 4, LDr1r2) \
+    X(0x42, "LD B,D", 4, LDr1r2) \
+    X(0x43, "LD B,E", 4, LDr1r2) \
+    X(0x44, "LD B,H", 4, LDr1r2) \
+    X(0x45, "LD B,L", 4, LDr1r2) \
+    X(0x46, "LD B,(HL)", 8, LDr1r2) \
+    X(0x47, "LD B,A", 4, LDr1r2) \
+    X(0x48, "LD C,B", 4, LDr1r2) \
+    X(0x49, "LD C,C", 4, LDr1r2) \
+    X(0x4A, "LD C,D", 4, LDr1r2) \
+    X(0x4B, "LD C,E", 4, LDr1r2) \
+    X(0x4C, "LD C,H", 4, LDr1r2) \
+    X(0x4D, "LD C,L", 4, LDr1r2) \
+    X(0x4E, "LD C,(HL)", 8, LDr1r2) \
+    X(0x4F, "LD C,A", 4, LDr1r2) \
+    X(0x50, "LD D,B", 4, LDr1r2) \
+    X(0x51, "LD D,C", 4, LDr1r2) \
+    X(0x52, "LD D,D", 4, LDr1r2) \
+    X(0x53, "LD D,E", 4, LDr1r2) \
+    X(0x54, "LD D,H", 4, LDr1r2) \
+    X(0x55, "LD D,L", 4, LDr1r2) \
+    X(0x56, "LD D,(HL)", 8, LDr1r2) \
+    X(0x57, "LD D,A", 4, LDr1r2) \
+    X(0x58, "LD E,B", 4, LDr1r2) \
+    X(0x59, "LD E,C", 4, LDr1r2) \
+    X(0x5A, "LD E,D", 4, LDr1r2) \
+    X(0x5B, "LD E,E", 4, LDr1r2) \
+    X(0x5C, "LD E,H", 4, LDr1r2) \
+    X(0x5D, "LD E,L", 4, LDr1r2) \
+    X(0x5E, "LD E,(HL)", 8, LDr1r2) \
+    X(0x5F, "LD E,A", 4, LDr1r2) \
+    X(0x60, "LD H,B", 4, LDr1r2) \
+    X(0x61, "LD H,C", 4, LDr1r2) \
+    X(0x62, "LD H,D", 4, LDr1r2) \
+    X(0x63, "LD H,E", 4, LDr1r2) \
+    X(0x64, "LD H,H", 4, LDr1r2) \
+    X(0x65, "LD H,L", 4, LDr1r2) \
+    X(0x66, "LD H,(HL)", 8, LDr1r2) \
+    X(0x67, "LD H,A", 4, LDr1r2) \
+    X(0x68, "LD L,B", 4, LDr1r2) \
+    X(0x69, "LD L,C", 4, LDr1r2) \
+    X(0x6A, "LD L,D", 4, LDr1r2) \
+    X(0x6B, "LD L,E", 4, LDr1r2) \
+    X(0x6C, "LD L,H", 4, LDr1r2) \
+    X(0x6D, "LD L,L", 4, LDr1r2) \
+    X(0x6E, "LD L,(HL)", 8, LDr1r2) \
+    X(0x6F, "LD L,A", 4, LDr1r2) \
+    X(0x70, "LD (HL),B", 8, LDr1r2) \
+    X(0x71, "LD (HL),C", 8, LDr1r2) \
+    X(0x72, "LD (HL),D", 8, LDr1r2) \
+    X(0x73, "LD (HL),E", 8, LDr1r2) \
+    X(0x74, "LD (HL),H", 8, LDr1r2) \
+    X(0x75, "LD (HL),L", 8, LDr1r2) \
+    X(0x76, "HALT", 4, HALT) \
+    X(0x77, "LD (HL),A", 8, LDr1r2) \
+    X(0x78, "LD A,B", 4, LDr1r2) \
+    X(0x79, "LD A,C", 4, LDr1r2) \
+    X(0x7A, "LD A,D", 4, LDr1r2) \
+    X(0x7B, "LD A,E", 4, LDr1r2) \
+    X(0x7C, "LD A,H", 4, LDr1r2) \
+    X(0x7D, "LD A,L", 4, LDr1r2) \
+    X(0x7E, "LD A,(HL)", 8, LDr1r2) \
+    X(0x7F, "LD A,A", 4, LDr1r2) \
+    X(0x80, "ADD A,B", 4, ADD) \
+    X(0x81, "ADD A,C", 4, ADD) \
+    X(0x82, "ADD A,D", 4, ADD) \
+    X(0x83, "ADD A,E", 4, ADD) \
+    X(0x84, "ADD A,H", 4, ADD) \
+    X(0x85, "ADD A,L", 4, ADD) \
+    X(0x86, "ADD A,(HL)", 8, ADD) \
+    X(0x87, "ADD A,A", 4, ADD) \
+    X(0x88, "ADC A,B", 4, ADD) \
+    X(0x89, "ADC A,C", 4, ADD) \
+    X(0x8A, "ADC A,D", 4, ADD) \
+    X(0x8B, "ADC A,E", 4, ADD) \
+    X(0x8C, "ADC A,H", 4, ADD) \
+    X(0x8D, "ADC A,L", 4, ADD) \
+    X(0x8E, "ADC A,(HL)", 8, ADD) \
+    X(0x8F, "ADC A,A", 4, ADD) \
+    X(0x90, "SUB B", 4, SUB) \
+    X(0x91, "SUB C", 4, SUB) \
+    X(0x92, "SUB D", 4, SUB) \
+    X(0x93, "SUB E", 4, SUB) \
+    X(0x94, "SUB H", 4, SUB) \
+    X(0x95, "SUB L", 4, SUB) \
+    X(0x96, "SUB (HL)", 8, SUB) \
+    X(0x97, "SUB A", 4, SUB) \
+    X(0x98, "SBC A,B", 4, SUB) \
+    X(0x99, "SBC A,C", 4, SUB) \
+    X(0x9A, "SBC A,D", 4, SUB) \
+    X(0x9B, "SBC A,E", 4, SUB) \
+    X(0x9C, "SBC A,H", 4, SUB) \
+    X(0x9D, "SBC A,L", 4, SUB) \
+    X(0x9E, "SBC A,(HL)", 8, SUB) \
+    X(0x9F, "SBC A,A", 4, SUB) \
+    X(0xA0, "AND B", 4, AND) \
+    X(0xA1, "AND C", 4, AND) \
+    X(0xA2, "AND D", 4, AND) \
+    X(0xA3, "AND E", 4, AND) \
+    X(0xA4, "AND H", 4, AND) \
+    X(0xA5, "AND L", 4, AND) \
+    X(0xA6, "AND (HL)", 8, AND) \
+    X(0xA7, "AND A", 4, AND) \
+    X(0xA8, "XOR B", 4, XOR) \
+    X(0xA9, "XOR C", 4, XOR) \
+    X(0xAA, "XOR D", 4, XOR) \
+    X(0xAB, "XOR E", 4, XOR) \
+    X(0xAC, "XOR H", 4, XOR) \
+    X(0xAD, "XOR L", 4, XOR) \
+    X(0xAE, "XOR (HL)", 8, XOR) \
+    X(0xAF, "XOR A", 4, XOR) \
+    X(0xB0, "OR B", 4, OR) \
+    X(0xB1, "OR C", 4, OR) \
+    X(0xB2, "OR D", 4, OR) \
+    X(0xB3, "OR E", 4, OR) \
+    X(0xB4, "OR H", 4, OR) \
+    X(0xB5, "OR L", 4, OR) \
+    X(0xB6, "OR (HL)", 8, OR) \
+    X(0xB7, "OR A", 4, OR) \
+    X(0xB8, "CP B", 4, CP) \
+    X(0xB9, "CP C", 4, CP) \
+    X(0xBA, "CP D", 4, CP) \
+    X(0xBB, "CP E", 4, CP) \
+    X(0xBC, "CP H", 4, CP) \
+    X(0xBD, "CP L", 4, CP) \
+    X(0xBE, "CP (HL)", 8, CP) \
+    X(0xBF, "CP A", 4, CP) \
+    X(0xC0, "RET NZ", 8, retcc) \
+    X(0xC1, "POP BC", 12, popNN) \
+    X(0xC2, "JP NZ,nn", 12, JPccnn) \
+    X(0xC3, "JP nn", 16, JPnn) \
+    X(0xC4, "CALL NZ,nn", 12, CAL) \
+    X(0xC5, "PUSH BC", 16, pushNN) \
+    X(0xC6, "ADD A,#", 8, ADD) \
+    X(0xC7, "RST $00", 32, RST) \
+    X(0xC8, "RET Z", 8, retcc) \
+    X(0xC9, "RET", 8, ret) \
+    X(0xCA, "JP Z,nn", 12, JPccnn) \
+    X(0xCB, "CB xx", 8, CB) \
+    X(0xCC, "CALL Z,nn", 12, CAL) \
+    X(0xCD, "CALL nn", 12, CAL) \
+    X(0xCE, "ADD A,#", 8, ADD) \
+    X(0xCF, "RST $08", 32, RST) \
+    X(0xD0, "RET NC", 8, retcc) \
+    X(0xD1, "POP DE", 12, popNN) \
+    X(0xD2, "JP NC,nn", 12, JPccnn) \
+    X(0xD3, "UNUSED", 0, UNUSED) \
+    X(0xD4, "CALL NC,nn", 12, CAL) \
+    X(0xD5, "PUSH DE", 16, pushNN) \
+    X(0xD6, "SUB n", 8, SUB) \
+    X(0xD7, "RST $10", 32, RST) \
+    X(0xD8, "RET C", 8, retcc) \
+    X(0xD9, "RETI", 8, reti) \
+    X(0xDA, "JP C,nn", 12, JPccnn) \
+    X(0xDB, "UNUSED", 0, UNUSED) \
+    X(0xDC, "CALL C,nn", 12, CAL) \
+    X(0xDD, "UNUSED", 0, UNUSED) \
+    X(0xDE, "SBC A,#", 8, SUB) \
+    X(0xDF, "RST $18", 32, RST) \
+    X(0xE0, "LD ($FF00+n),A", 12, LDr1r2) \
+    X(0xE1, "POP HL", 12, popNN) \
+    X(0xE2, "LD ($FF00+C),A", 8, LDr1r2) \
+    X(0xE3, "UNUSED", 0, UNUSED) \
+    X(0xE4, "UNUSED", 4, UNUSED) \
+    X(0xE5, "PUSH HL", 16, pushNN) \
+    X(0xE6, "AND #", 8, AND) \
+    X(0xE7, "RST $20", 32, RST) \
+    X(0xE8, "ADD SP,r8", 16, ADDSPr8) \
+    X(0xE9, "JP (HL)", 4, JPHL) \
+    X(0xEA, "LD (nn),A", 16, LDr1r2) \
+    X(0xEB, "UNUSED", 0, UNUSED) \
+    X(0xEC, "UNUSED", 0, UNUSED) \
+    X(0xED, "UNUSED", 0, UNUSED) \
+    X(0xEE, "XOR #", 8, XOR) \
+    X(0xEF, "RST $28", 32, RST) \
+    X(0xF0, "LD A,($FF00+n)", 12, LDr1r2) \
+    X(0xF1, "POP AF", 12, popNN) \
+    X(0xF2, "LD A,($FF00+C)", 8, LDr1r2) \
+    X(0xF3, "di", 4, di) \
+    X(0xF4, "UNUSED", 0, UNUSED) \
+    X(0xF5, "PUSH AF", 16, pushNN) \
+    X(0xF6, "OR #", 8, OR) \
+    X(0xF7, "RST $30", 32, RST) \
+    X(0xF8, "LDHL SP,n", 12, LDHLSPn) \
+    X(0xF9, "LD SP,HL", 8, LDSPHL) \
+    X(0xFA, "LD A,(nn)", 16, LDr1r2) \
+    X(0xFB, "EI", 4, ei) \
+    X(0xFC, "UNUSED", 0, UNUSED) \
+    X(0xFD, "UNUSED", 0, UNUSED) \
+    X(0xFE, "CP #", 8, CP) \
+    X(0xFF, "RST $38", 32, RST)
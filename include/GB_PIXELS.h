@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+//Pixel kernels shared by the background, window and sprite renderers
+//
+//Each kernel has a scalar version and, on x86, SSE2 and AVX2 ones. The fastest one the cpu
+//supports is picked when the program starts, use() overrides that choice.
+//All versions produce the same bytes.
+class GB_PIXELS {
+    public:
+        enum level {
+            SCALAR,
+            SSE2,
+            AVX2
+        };
+
+        //Color numbers of the 64 pixels of a tile, row by row and left to right, from its 16 bytes of 2bpp data
+        static void (*decodeTile)(const uint8_t* data, uint8_t* colors);
+
+        //Writes palette[color] as 4 bytes in host byte order for each of count color numbers
+        static void (*mapColors)(const uint8_t* colors, int count, const uint32_t* palette, uint8_t* out);
+
+        //Highest level supported by the cpu
+        static level best();
+
+        //Switches every kernel to level, or to the best supported one below it
+        static void use(level wanted);
+
+        static level current();
+
+        static const char* name(level l);
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Work stealing thread pool
+//Every worker owns a queue. It takes its own tasks newest first and, once it runs out, steals the
+//oldest task of another worker. Tasks submitted from a worker go to that worker's queue, so a task
+//that resubmits its continuation keeps running on the same thread unless another one is idle.
+class GB_POOL {
+    public:
+        GB_POOL(unsigned int threads = std::thread::hardware_concurrency());
+        ~GB_POOL();
+
+        void submit(std::function<void()> task);
+
+        //Blocks until every submitted task, including the ones submitted by tasks, has run
+        void wait();
+
+        unsigned int size();
+
+    private:
+        struct queue {
+            std::mutex lock;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<queue>> queues;
+        std::vector<std::thread> workers;
+
+        std::atomic<int> queued{0}; //Tasks waiting in a queue
+        std::atomic<int> pending{0}; //Tasks submitted and not finished
+        std::atomic<unsigned int> nextQueue{0};
+        bool stopping = false;
+
+        std::mutex idleLock;
+        std::condition_variable idle;
+        std::condition_variable done;
+
+        //Index of the worker running on this thread, -1 outside of the pool
+        static thread_local int current;
+
+        void work(int index);
+        bool take(int index, std::function<void()>& task);
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include "GB.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+//History of recent machine states to step back through
+//
+//A snapshot is taken every interval frames. Every keyframeInterval snapshots one is stored whole,
+//the ones in between only as their difference to that keyframe: the two states XORed, which leaves
+//mostly zeros, then run length encoded. Restoring any snapshot decodes at most two of them.
+//Once the history takes more than budget bytes, the oldest keyframe is dropped together with its deltas.
+class GB_REWIND {
+    public:
+        GB_REWIND(GB& gameboy, int interval = 2, int keyframeInterval = 60, size_t budget = 8 * 1024 * 1024);
+
+        //Call between frames, takes a snapshot once interval frames have passed since the last one
+        void capture();
+
+        //Restores the newest snapshot taken at or before frame and forgets the ones after it
+        //Returns false if no snapshot is old enough
+        bool rewind(uint64_t frame);
+
+        //Restores the snapshot before the current frame
+        bool stepBack();
+
+        //Frames covered by the history, 0 and 0 if it is empty
+        uint64_t oldestFrame();
+        uint64_t newestFrame();
+
+        //Bytes held by encoded snapshots
+        size_t memoryUsed();
+
+        void clear();
+
+    private:
+        struct snapshot {
+            uint64_t frame;
+            bool keyframe;
+            std::vector<uint8_t> data; //XOR against the keyframe, or against zeros for a keyframe, run length encoded
+        };
+
+        GB& gameboy;
+        int interval;
+        int keyframeInterval;
+        size_t budget;
+
+        std::deque<snapshot> history;
+        size_t used = 0;
+        int sinceKeyframe = 0;
+
+        std::vector<uint8_t> state; //Scratch state of the machine
+        std::vector<uint8_t> keyframe; //Decoded state of the newest keyframe
+        std::vector<std::vector<uint8_t>> spare; //Buffers of dropped snapshots, reused for new ones
+
+        //Drops the oldest keyframe and every delta depending on it
+        void dropOldest();
+
+        //Decodes the snapshot at index into state
+        void restore(size_t index);
+
+        //Appends the run length encoding of current XOR base, base being nullptr for zeros
+        static void encode(const uint8_t* current, const uint8_t* base, size_t size, std::vector<uint8_t>& out);
+
+        //XORs an encoding into out
+        static void decode(const std::vector<uint8_t>& in, uint8_t* out, size_t size);
+};
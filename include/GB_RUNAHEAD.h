@@ -0,0 +1,24 @@
+#pragma once
+#include "GB.h"
+#include <vector>
+
+//Hides the game's own input lag by showing frames from the future
+//
+//Every call runs the real frame, snapshots the machine, runs frames more frames with the same input,
+//presents the last of them and restores the snapshot. What's on screen then already reacts to input
+//that the game would only have shown frames later. The speculative frames before the presented one
+//skip drawing, and GB::frameHandler only runs for the real frame, so pacing and window events happen once.
+class GB_RUNAHEAD {
+    public:
+        //0 turns run ahead off
+        int frames;
+
+        GB_RUNAHEAD(GB& gameboy, int frames = 0);
+
+        //Returns false if the cpu stopped
+        bool runFrame();
+
+    private:
+        GB& gameboy;
+        std::vector<uint8_t> state;
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include "GB.h"
+#include "GB_POOL.h"
+#include "GB_MOVIE.h"
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//One cartridge run of a batch
+struct GB_INSTANCE {
+    std::string rom;
+    uint64_t frameBudget = 0;
+    std::string inputScript;
+
+    GB_MOVIE movie;
+    std::unique_ptr<GB_PLAYER> player;
+
+    //Only alive while the instance is running
+    std::unique_ptr<GB> gameboy;
+
+    //Results
+    uint64_t frames = 0;
+    std::string error;
+    double seconds = 0; //Time spent emulating, summed over the slices
+    uint64_t screenHash = 0; //FNV-1a of the last frame
+};
+
+//Runs many headless instances in parallel, each one stepped in slices of frames
+//
+//Manifest format, one instance per line, blank lines and lines starting with # are ignored:
+//  <rom> <frames> [input script]
+//The input script is either a movie recorded with GB_RECORDER, or a text file with one change per line:
+//  <frame> <buttons>
+//where buttons is the mask held from that frame on, in decimal or 0x hex
+class GB_RUNNER {
+    public:
+        //Frames run by one task before the instance goes back into the pool
+        static const int SLICE_FRAMES = 60;
+
+        std::vector<GB_INSTANCE> instances;
+
+        //Wall clock time of the last run
+        double seconds = 0;
+
+        //Returns false and prints the offending line if the manifest can't be read
+        bool loadManifest(const std::string& fileName);
+
+        void run(unsigned int threads);
+
+        void report(std::ostream& out);
+
+    private:
+        void runSlice(GB_POOL& pool, GB_INSTANCE& instance);
+
+        static bool start(GB_INSTANCE& instance);
+
+        static bool loadInputs(GB_INSTANCE& instance);
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include "GB_STATE.h"
+
+//Central timeline of the emulator, in cpu cycles since power on
+//
+//Every component that does something at a known time registers a handler for its event type
+//and schedules the event for when it next needs attention. The cpu runs uninterrupted until
+//the earliest scheduled event, then advance() moves the clock and runs the handlers that are due.
+//A handler usually brings its component up to date and schedules that component's next event.
+//
+//Each event type has at most one pending timestamp, scheduling it again replaces the old one.
+//
+//Adding a component (APU, serial port...):
+//  - add its entry to event, before EVENT_COUNT
+//  - setHandler() once at startup and schedule() the first occurrence
+//  - schedule() again from the handler, and whenever a register write moves the next occurrence
+class GB_SCHEDULER {
+    public:
+        //Events due at the same time run in this order
+        enum event {
+            EVENT_PPU, //Lcd mode change, line end or pending stat interrupt
+            EVENT_TIMER, //Next TIMA increment
+            EVENT_FRAME, //Frame boundary, used by the frontend for pacing and window events
+            EVENT_JOYPAD, //Input poll, once per frame after the window events were pumped
+            EVENT_COUNT
+        };
+
+        static const uint64_t NEVER = UINT64_MAX;
+
+        //Cycles elapsed up to the end of the last cpu run
+        uint64_t now = 0;
+
+        //True while advance() is running handlers
+        bool dispatching = false;
+
+        GB_SCHEDULER();
+
+        //handler is called with the time the event was scheduled for, which may be slightly before now
+        void setHandler(event type, std::function<void(uint64_t)> handler);
+
+        void schedule(event type, uint64_t time);
+
+        void scheduleIn(event type, int cycles);
+
+        void cancel(event type);
+
+        //Returns NEVER if the event isn't scheduled
+        uint64_t timeOf(event type);
+
+        //Cycles the cpu can run before the next event is due, 0 if one already is
+        int cyclesUntilNextEvent();
+
+        //Moves the clock forward and runs every handler due by the new time, earliest first
+        //Each event runs at most once per call, one rescheduled at or before now waits for the next cpu run
+        void advance(int cycles);
+
+        //Only the clock and the pending times, handlers belong to the owner
+        void serialize(GB_STATE& state);
+
+    private:
+        uint64_t times[EVENT_COUNT];
+        std::function<void(uint64_t)> handlers[EVENT_COUNT];
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include "GB.h"
+#include "GB_MAILBOX.h"
+#include "GB_REWIND.h"
+#include "GB_RUNAHEAD.h"
+#include "SDL.h"
+#include <atomic>
+#include <chrono>
+
+//SDL window, keyboard and frame pacing around a GB core
+//
+//The emulator runs on its own thread and publishes every finished frame to a mailbox. The thread
+//calling run() owns the window: it handles events, samples the keyboard and presents the newest
+//frame, so a slow present or vsync never holds back the emulator.
+class GB_SDL : public GB_INPUT {
+    public:
+        GB& gameboy;
+
+        //Stepped back through while backspace is held
+        GB_REWIND rewind;
+
+        //Off unless its frames are set
+        GB_RUNAHEAD runAhead;
+
+        uint8_t scale = 3;
+        SDL_Window* window = nullptr;
+        SDL_Renderer* renderer = nullptr;
+
+        //Streaming texture the newest frame is uploaded to, scaled to the window by the renderer
+        SDL_Texture* texture = nullptr;
+
+        //The gpu draws lines straight into its back buffer
+        GB_MAILBOX mailbox;
+
+        const int SCREEN_FPS = 60;
+
+        //Multiple of normal speed while tab is held, 0 runs as fast as possible
+        //Only about SCREEN_FPS frames a second are drawn then, the gpu skips the others
+        double turboSpeed = 0;
+
+        GB_SDL(GB& gameboy);
+        ~GB_SDL();
+
+        //Runs the emulator until the window is closed, the cpu stops or, unless negative, frames frames have run
+        void run(long frames = -1);
+
+        //Emulator thread: publishes the frame just drawn unless no line changed since the last one,
+        //copying GB_GPU::screen if the back buffer doesn't hold all of it
+        void drawFrame();
+
+        //Emulator thread: waits for the rest of the frame time at the current speed and sets the gpu's frame skip
+        void endFrame();
+
+        //Window thread: shows the newest published frame, returns false if there was none
+        bool present();
+
+        //Pressed buttons as expected by GB_MEM::handleButton
+        uint8_t readButtons();
+
+        //Keyboard state last sampled by the window thread, the frame doesn't matter
+        uint8_t poll(uint64_t frame) override;
+
+    private:
+        //Written by the window thread, read by the emulator thread
+        std::atomic<uint8_t> buttons{0};
+        std::atomic<bool> rewinding{false};
+        std::atomic<bool> fastForward{false};
+        std::atomic<bool> stopping{false};
+
+        //Set by the emulator thread once it returns
+        std::atomic<bool> finished{false};
+
+        //Emulator thread pacing
+        std::chrono::steady_clock::time_point nextFrame;
+        std::chrono::steady_clock::time_point measureStart;
+        int measuredFrames = 0;
+
+        void emulate(long frames);
+
+        //Window thread: handles pending events and samples the keyboard
+        void handleEvents();
+};
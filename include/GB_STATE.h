@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//Save state buffer, shared by saving and loading so every component lists its fields once
+//
+//Format, fields in host byte order:
+//  header - magic "GGBS", format version, payload size, rom id, payload checksum
+//  payload - every component's serialize() in the order GB calls them, raw field bytes without padding or tags
+//A state is only loaded if all of the header matches and its payload is exactly as long as the fields
+//serialize() reads, so a rejected state never leaves a half loaded machine.
+//VERSION must be bumped whenever a serialized field is added, removed or resized.
+class GB_STATE {
+    public:
+        static const uint32_t MAGIC = 0x53424747;
+        static const uint32_t VERSION = 1;
+
+        struct header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t size;
+            uint32_t rom;
+            uint64_t checksum;
+        };
+
+        //Saving writes from offset start of data on, growing it as needed
+        GB_STATE(std::vector<uint8_t>& data, size_t start = 0);
+
+        //Loading reads size bytes of payload from data
+        GB_STATE(const uint8_t* data, size_t size);
+
+        //Measuring only counts the bytes a save would write
+        GB_STATE();
+
+        bool loading;
+
+        //Set when a load runs past the end of the payload
+        bool failed = false;
+
+        template<typename T>
+        void field(T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "only plain data can be copied into a state");
+            bytes(&value, sizeof(T));
+        }
+
+        void bytes(void* value, size_t size)
+        {
+            if(loading)
+            {
+                if(size > inputSize - position)
+                {
+                    failed = true;
+                    return;
+                }
+                memcpy(value, input + position, size);
+            }
+            else if(output != nullptr)
+            {
+                if(output->size() < position + size)
+                    output->resize(position + size);
+                memcpy(output->data() + position, value, size);
+            }
+            position += size;
+        }
+
+        //Offset reached in the data
+        size_t size();
+
+        //Word at a time, a state is hashed in well under the time it takes to copy it
+        static uint64_t checksum(const uint8_t* data, size_t size);
+
+        //Identifies the cartridge a state belongs to, from its header
+        static uint32_t romId(const std::vector<unsigned char>& rom);
+
+    private:
+        std::vector<uint8_t>* output = nullptr;
+        const uint8_t* input = nullptr;
+        size_t inputSize = 0;
+        size_t position = 0;
+};
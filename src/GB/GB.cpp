@@ -1,53 +1,172 @@
 #include "GB.h"
 
-GB::GB(std::string fileName) {
-    cpu.memory = mem;
-    gpu.memory = mem;
-    mem->loadRom(fileName);
+GB::GB(std::string fileName, bool loadSave) {
+    loaded = mem.loadRom(fileName, loadSave);
+    powerOn();
+}
+
+GB::GB(std::vector<unsigned char> rom, bool loadSave) {
+    loaded = mem.loadRom(std::move(rom), loadSave);
+    powerOn();
+}
+
+void GB::powerOn() {
     cpu.reg.pc = 0x0100;
     cpu.reg.sp = 0xFFFE;
+#ifdef GGBOY_JIT
+    cpu.jit = std::make_unique<GB_JIT>(&cpu, mem);
+#endif
+    mem.syncHandler = [this]() {
+        //Register writes made by the gpu from its own event don't affect the other components
+        if(!scheduler.dispatching)
+            syncComponents(scheduler.now + cpu.batchCycles);
+    };
+
+    scheduler.setHandler(GB_SCHEDULER::EVENT_PPU, [this](uint64_t) {
+        syncGPU(scheduler.now);
+        scheduler.scheduleIn(GB_SCHEDULER::EVENT_PPU, gpu.cyclesUntilNextEvent());
+    });
+    scheduler.setHandler(GB_SCHEDULER::EVENT_TIMER, [this](uint64_t) {
+        syncTimers(scheduler.now);
+        scheduler.scheduleIn(GB_SCHEDULER::EVENT_TIMER, mem.cyclesUntilTimerEvent());
+    });
+    scheduler.setHandler(GB_SCHEDULER::EVENT_FRAME, [this](uint64_t time) {
+        frames++;
+        if(frameHandler)
+            frameHandler();
+        scheduler.schedule(GB_SCHEDULER::EVENT_FRAME, time + CYCLES_PER_FRAME);
+    });
+    scheduler.setHandler(GB_SCHEDULER::EVENT_JOYPAD, [this](uint64_t time) {
+        mem.handleButton(input != nullptr ? input->poll(frames) : 0);
+        scheduler.schedule(GB_SCHEDULER::EVENT_JOYPAD, time + CYCLES_PER_FRAME);
+    });
+
+    scheduler.schedule(GB_SCHEDULER::EVENT_PPU, 0);
+    scheduler.schedule(GB_SCHEDULER::EVENT_TIMER, 0);
+    scheduler.schedule(GB_SCHEDULER::EVENT_FRAME, CYCLES_PER_FRAME);
+    scheduler.schedule(GB_SCHEDULER::EVENT_JOYPAD, CYCLES_PER_FRAME);
+
+    mem.data()[0xFF00] = 0xFF;
+    mem.write(0xFF40, mem.read(0xFF40) | 0b10000000);
 }
 
 void GB::execute() {
-    mem->data()[0xFF00] = 0xFF;
-    mem->write(0xFF40, mem->read(0xFF40) | 0b10000000);
-    short cycles = 0;
-    int totalCycles = 0;
-    auto ticks = SDL_GetTicks();
-    while(cycles != -1 && !quit)
+    while(!quit)
     {
-        // Uncomment if using gameboy-doctor
-        // cpu.printRegsForLog();
-
-        if(totalCycles >= 70224)//Only handle input and events once per frame
-        {
-            //Handle SDL Events
-            while(SDL_PollEvent(&e) != 0)
-            {
-                //User requests quit
-                if(e.type == SDL_QUIT)
-                    quit = true;
-            }
-
-            const unsigned char* keystate = SDL_GetKeyboardState(NULL);
-            mem->handleButton(keystate);
-
-            //If frame finished early
-            int frameTicks = SDL_GetTicks() - ticks;
-            if( frameTicks < SCREEN_TICKS_PER_FRAME )
-            {
-                //Wait remaining time
-                SDL_Delay( SCREEN_TICKS_PER_FRAME - frameTicks );
-            }
-
-            ticks = SDL_GetTicks();
-            totalCycles -= 70224;
-        }
-
-        cycles = cpu.execute();
-        gpu.update(cycles);
-        mem->updateTimers(cycles);
-
-        totalCycles += cycles;
+        if(!step())
+            break;
     }
 }
+
+bool GB::runFrame() {
+    uint64_t frame = frames;
+    while(frames == frame)
+    {
+        if(!step())
+            return false;
+    }
+    return true;
+}
+
+const uint8_t* GB::framebuffer() const {
+    return &gpu.screen[0][0][0];
+}
+
+void GB::saveState(std::vector<uint8_t>& state) {
+    GB_STATE writer(state, sizeof(GB_STATE::header));
+    serialize(writer);
+    state.resize(writer.size());
+
+    GB_STATE::header header;
+    header.magic = GB_STATE::MAGIC;
+    header.version = GB_STATE::VERSION;
+    header.size = state.size() - sizeof(header);
+    header.rom = GB_STATE::romId(mem.fullRom);
+    header.checksum = GB_STATE::checksum(state.data() + sizeof(header), header.size);
+    memcpy(state.data(), &header, sizeof(header));
+}
+
+bool GB::loadState(const std::vector<uint8_t>& state) {
+    GB_STATE::header header;
+    if(state.size() < sizeof(header))
+        return false;
+    memcpy(&header, state.data(), sizeof(header));
+
+    const uint8_t* payload = state.data() + sizeof(header);
+    if(header.magic != GB_STATE::MAGIC || header.version != GB_STATE::VERSION || header.size != state.size() - sizeof(header)
+        || header.rom != GB_STATE::romId(mem.fullRom) || header.checksum != GB_STATE::checksum(payload, header.size))
+        return false;
+
+    //Every field has a fixed size, a payload of any other length was written with a different layout
+    GB_STATE measure;
+    serialize(measure);
+    if(header.size != measure.size())
+        return false;
+
+    GB_STATE reader(payload, header.size);
+    serialize(reader);
+    return !reader.failed;
+}
+
+bool GB::saveStateFile(const std::string& fileName) {
+    std::vector<uint8_t> state;
+    saveState(state);
+    std::ofstream file(fileName, std::ios::binary);
+    file.write((char*)state.data(), state.size());
+    return file.good();
+}
+
+bool GB::loadStateFile(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+    if(!file)
+        return false;
+    std::vector<uint8_t> state((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return loadState(state);
+}
+
+void GB::serialize(GB_STATE& state) {
+    state.field(frames);
+    state.field(gpuSyncedTo);
+    state.field(timersSyncedTo);
+    scheduler.serialize(state);
+    cpu.serialize(state);
+    mem.serialize(state);
+    gpu.serialize(state);
+}
+
+bool GB::step() {
+    // Uncomment if using gameboy-doctor
+    // cpu.printRegsForLog();
+
+    //Run the cpu until the next event is due, then handle every event that is
+    int cycles = cpu.run(scheduler.cyclesUntilNextEvent());
+    if(cycles == -1)
+        return false;
+
+    cpu.batchCycles = 0; //Those cycles now belong to the scheduler clock
+    scheduler.advance(cycles);
+    return true;
+}
+
+void GB::syncComponents(uint64_t time) {
+    //Nothing has run since the last sync at the start of a cpu run, and updating with 0 cycles could handle an event early
+    if(time != gpuSyncedTo)
+        syncGPU(time);
+    if(time != timersSyncedTo)
+        syncTimers(time);
+
+    scheduler.schedule(GB_SCHEDULER::EVENT_PPU, time);
+    scheduler.schedule(GB_SCHEDULER::EVENT_TIMER, time);
+}
+
+void GB::syncGPU(uint64_t time) {
+    int pending = time - gpuSyncedTo;
+    gpuSyncedTo = time; //Set first, the gpu writes its own registers while updating
+    gpu.update(pending);
+}
+
+void GB::syncTimers(uint64_t time) {
+    int pending = time - timersSyncedTo;
+    timersSyncedTo = time;
+    mem.updateTimers(pending);
+}
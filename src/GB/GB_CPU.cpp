@@ -1,25 +1,142 @@
 #include "GB_CPU.h"
+#include <utility>
+
+#define GB_INSTRUCTION(op, disassembly, cycles, handler) &GB_CPU::handler<op>,
+constexpr std::array<void (GB_CPU::*)(), 256> GB_CPU::instructions = {{
+    GB_OPCODES(GB_INSTRUCTION)
+}};
+#undef GB_INSTRUCTION
+
+#define GB_DISASSEMBLY(op, disassembly, cycles, handler) disassembly,
+constexpr const char* GB_CPU::disassembly[256] = {
+    GB_OPCODES(GB_DISASSEMBLY)
+};
+#undef GB_DISASSEMBLY
+
+template<std::size_t... ops>
+static constexpr std::array<void (GB_CPU::*)(), 256> makeCBTable(std::index_sequence<ops...>) {
+    return {{ &GB_CPU::CBop<ops>... }};
+}
+
+constexpr std::array<void (GB_CPU::*)(), 256> GB_CPU::cbInstructions = makeCBTable(std::make_index_sequence<256>());
+
+//Flag and result tables, built at compile time
+//About 9KB together, small enough to stay in L1 next to the dispatch tables
+
+//Result of each rotate and shift of the CB group (RLC, RRC, RL, RR, SLA, SRA, SWAP, SRL) for every operand,
+//with its N, H and C flags in the high byte at their reg.f positions
+//RL and RR shift in a 0, the handler adds the old carry
+static constexpr std::array<std::array<uint16_t, 256>, 8> makeShiftResults() {
+    std::array<std::array<uint16_t, 256>, 8> table = {};
+    for(int value = 0; value < 256; value++)
+    {
+        uint8_t bit7 = value >> 7;
+        uint8_t bit0 = value & 1;
+        uint8_t results[8] = {
+            uint8_t((value << 1) | bit7), uint8_t((value >> 1) | (bit0 << 7)),
+            uint8_t(value << 1), uint8_t(value >> 1),
+            uint8_t(value << 1), uint8_t((value >> 1) | (value & 0x80)),
+            uint8_t((value << 4) | (value >> 4)), uint8_t(value >> 1)
+        };
+        uint8_t carries[8] = {bit7, bit0, bit7, bit0, bit7, bit0, 0, bit0};
+        for(int type = 0; type < 8; type++)
+            table[type][value] = results[type] | (carries[type] << C_FLAG) << 8;
+    }
+    return table;
+}
+
+//DAA result for every value of A and of the N, H and C flags, with the new Z, N, H and C flags in the high byte
+static constexpr std::array<std::array<uint16_t, 256>, 8> makeDAAResults() {
+    std::array<std::array<uint16_t, 256>, 8> table = {};
+    for(int nhc = 0; nhc < 8; nhc++)
+    {
+        bool n = nhc & 4, h = nhc & 2, c = nhc & 1;
+        for(int a = 0; a < 256; a++)
+        {
+            uint8_t offset = 0;
+            bool carry = c;
+            if(h || (!n && (a & 0x0f) > 0x09)) //Digits > 9
+                offset |= 0x6;
+            if(c || (!n && a > 0x99))
+            {
+                offset |= 0x60;
+                carry = true;
+            }
+
+            uint8_t result = n ? a - offset : a + offset;
+            uint8_t flags = (result == 0) << Z_FLAG | n << N_FLAG | carry << C_FLAG; //H reset
+            table[nhc][a] = result | flags << 8;
+        }
+    }
+    return table;
+}
+
+//N and H flags of INC (0) and DEC (1), by the low nibble of the result
+static constexpr std::array<std::array<uint8_t, 16>, 2> makeStepFlags() {
+    std::array<std::array<uint8_t, 16>, 2> table = {};
+    for(int nibble = 0; nibble < 16; nibble++)
+    {
+        table[0][nibble] = (nibble == 0x0) << H_FLAG;
+        table[1][nibble] = 1 << N_FLAG | (nibble == 0xf) << H_FLAG;
+    }
+    return table;
+}
+
+//N and H flags of ADD/ADC (0) and SUB/SBC/CP (1), by carry in and the low nibbles of both operands
+static constexpr std::array<std::array<std::array<std::array<uint8_t, 16>, 16>, 2>, 2> makeArithmeticFlags() {
+    std::array<std::array<std::array<std::array<uint8_t, 16>, 16>, 2>, 2> table = {};
+    for(int carry = 0; carry < 2; carry++)
+        for(int a = 0; a < 16; a++)
+            for(int b = 0; b < 16; b++)
+            {
+                table[0][carry][a][b] = (a + b + carry > 0xf) << H_FLAG;
+                table[1][carry][a][b] = 1 << N_FLAG | (a < b + carry) << H_FLAG;
+            }
+    return table;
+}
+
+alignas(64) static constexpr auto shiftResults = makeShiftResults();
+alignas(64) static constexpr auto daaResults = makeDAAResults();
+alignas(64) static constexpr auto stepFlags = makeStepFlags();
+alignas(64) static constexpr auto arithmeticFlags = makeArithmeticFlags();
+
+#ifdef GGBOY_JIT
+template<void (GB_CPU::*handler)()>
+static void handlerEntry(GB_CPU* cpu) {
+    (cpu->*handler)();
+}
+
+#define GB_ENTRY(op, disassembly, cycles, handler) &handlerEntry<&GB_CPU::handler<op>>,
+constexpr std::array<void (*)(GB_CPU*), 256> GB_CPU::handlerEntries = {{
+    GB_OPCODES(GB_ENTRY)
+}};
+#undef GB_ENTRY
+#endif
+
+GB_CPU::GB_CPU(GB_MEM& memory) : memory(memory) {
+}
 
 int16_t GB_CPU::execute() {
     if(stopped)
     {
-        if((memory->read(JOYPAD) & 0x0F) == 0x0F)
+        if((memory.read(JOYPAD) & 0x0F) == 0x0F)
             return 4;
         else
         {
-            memory->write(JOYPAD, lastJoypadState);
-            memory->write(LCDC, lastLCDState); //Re enable lcd if necessary
-            memory->write(TAC, lastTimerState);
+            memory.write(JOYPAD, lastJoypadState);
+            memory.write(LCDC, lastLCDState); //Re enable lcd if necessary
+            memory.write(TAC, lastTimerState);
             stopped = false;
         }
     }
 
-    uint8_t op = memory->read(reg.pc);
-    auto inst = instructions[op].execute;
+    uint8_t op = memory.read(reg.pc);
+    auto inst = instructions[op];
     if (inst != nullptr && !stopped)
     {
+        instructionCount += !halted; //A halted cpu keeps running its HALT until an interrupt comes
 
-        cycles = instructions[op].cycles;
+        cycles = opcodeCycles[op];
         (this->*inst)();
 
         checkInterrupts();
@@ -34,6 +151,106 @@ int16_t GB_CPU::execute() {
     return -1;
 }
 
+int GB_CPU::run(int budget) {
+    memory.syncRequested = false;
+    batchCycles = 0;
+
+#ifdef GGBOY_THREADED_INTERPRETER
+    //Threaded dispatch - every handler jumps straight to the next one
+    #define GB_LABEL(op, disassembly, opCycles, handler) &&op_##op,
+    static void* const labels[256] = { GB_OPCODES(GB_LABEL) };
+    #undef GB_LABEL
+
+    #define GB_DISPATCH() \
+        if(stopped) \
+            goto slow; \
+        goto *labels[memory.read(reg.pc)];
+
+    #define GB_NEXT() \
+        checkInterrupts(); \
+        batchCycles += cycles; \
+        cycles = 0; \
+        if(batchCycles >= budget || memory.syncRequested) \
+        { \
+            flags(); \
+            return batchCycles; \
+        } \
+        GB_DISPATCH()
+
+    GB_DISPATCH()
+
+    #define GB_HANDLER(op, disassembly, opCycles, handler) \
+        op_##op: \
+            instructionCount += op != 0x76 || !halted; \
+            cycles = opCycles; \
+            handler<op>(); \
+            GB_NEXT()
+    GB_OPCODES(GB_HANDLER)
+    #undef GB_HANDLER
+
+    slow: //Stopped cpu, handled by the table based step
+        batchCycles += execute();
+        if(batchCycles >= budget || memory.syncRequested)
+        {
+            flags();
+            return batchCycles;
+        }
+        GB_DISPATCH()
+
+    #undef GB_NEXT
+    #undef GB_DISPATCH
+#elif defined(GGBOY_JIT)
+    do
+    {
+        //Blocks can't raise interrupts, so one that starts with none pending only needs a check at its end
+        GB_JIT::block* block = stopped || halted ? nullptr : jit->find(reg.pc);
+        if(block != nullptr && block->code != nullptr && batchCycles + block->cyclesBeforeLast < budget
+            && !(reg.ime && (memory.read(IE) & memory.read(IF) & 0x1F)))
+        {
+            cycles = 0;
+            instructionCount += block->instructions;
+            block->code(this);
+            checkInterrupts();
+            batchCycles += cycles; //Taken branch cycles, the block adds the rest as it runs
+            cycles = 0;
+            continue;
+        }
+
+        int16_t stepCycles = execute();
+        if(stepCycles == -1)
+            return -1;
+        batchCycles += stepCycles;
+    } while(batchCycles < budget && !memory.syncRequested);
+
+    flags();
+    return batchCycles;
+#else
+    do
+    {
+        int16_t stepCycles = execute();
+        if(stepCycles == -1)
+            return -1;
+        batchCycles += stepCycles;
+    } while(batchCycles < budget && !memory.syncRequested);
+
+    flags();
+    return batchCycles;
+#endif
+}
+
+void GB_CPU::serialize(GB_STATE& state) {
+    if(!state.loading)
+        flags();
+    state.field(reg);
+    state.field(cycles);
+    state.field(lastJoypadState);
+    state.field(lastLCDState);
+    state.field(lastTimerState);
+    state.field(halted);
+    state.field(stopped);
+    lazy.kind = FLAGS_READY;
+}
+
 bool GB_CPU::checkInterrupts() {
     //Interrupts:
     //0 - V-Blank
@@ -45,13 +262,13 @@ bool GB_CPU::checkInterrupts() {
     {
         for(uint8_t i = 0; i < 5; i++)
         {
-            if((testBit(i, memory->read(IE)) || halted) && testBit(i, memory->read(IF))) //Check interrupt enable register and Interrupt flags
+            if((testBit(i, memory.read(IE)) || halted) && testBit(i, memory.read(IF))) //Check interrupt enable register and Interrupt flags
             {                                                                            //All interrupts are enabled if halted
                 if(halted)
                 {
                     halted = false;
                     reg.pc++;
-                    if(!reg.ime || !(testBit(i, memory->read(IE))))
+                    if(!reg.ime || !(testBit(i, memory.read(IE))))
                     {
                         return true;
                     }
@@ -70,20 +287,22 @@ bool GB_CPU::checkInterrupts() {
 }
 
 void GB_CPU::printRegs() {
-    std::cout << std::hex << "Instruction 0x" << static_cast<int>(memory->read(reg.pc)) << " , " << instructions[memory->read(reg.pc)].disassembly << "!\n";
+    flags();
+    std::cout << std::hex << "Instruction 0x" << static_cast<int>(memory.read(reg.pc)) << " , " << disassembly[memory.read(reg.pc)] << "!\n";
     std::cout << "AF: " << std::hex << std::setfill('0') << std::setw(4) << static_cast<int>(reg.af) << "\n";
     std::cout << std::hex << "BC: " << std::setfill('0') << std::setw(4) << static_cast<int>(reg.bc) << "\n";
     std::cout << std::hex << "DE: " << std::setfill('0') << std::setw(4) << static_cast<int>(reg.de) << "\n";
     std::cout << std::hex << "HL: " << std::setfill('0') << std::setw(4) << static_cast<int>(reg.hl) << "\n";
     std::cout << std::hex << "PC: " << std::setfill('0') << std::setw(4) << static_cast<int>(reg.pc) << "\n";
     std::cout << std::hex << "SP: " << std::setfill('0') << std::setw(4) << static_cast<int>(reg.sp) << "\n";
-    std::cout << std::hex << "LCDC: " << std::setfill('0') << std::setw(4) << static_cast<int>(memory->read(0xFF40)) << "\n";
-    std::cout << std::hex << "STAT: " << std::setfill('0') << std::setw(4) << static_cast<int>(memory->read(0xFF41)) << "\n";
-    std::cout << std::hex << "LY: " << std::setfill('0') << std::setw(4) << static_cast<int>(memory->read(0xFF44)) << "\n";
+    std::cout << std::hex << "LCDC: " << std::setfill('0') << std::setw(4) << static_cast<int>(memory.read(0xFF40)) << "\n";
+    std::cout << std::hex << "STAT: " << std::setfill('0') << std::setw(4) << static_cast<int>(memory.read(0xFF41)) << "\n";
+    std::cout << std::hex << "LY: " << std::setfill('0') << std::setw(4) << static_cast<int>(memory.read(0xFF44)) << "\n";
     std::cout << "Flags: " << std::bitset<8>(reg.f) << "\n";
 }
 
 void GB_CPU::printRegsForLog() {
+    flags();
     std::cout << std::uppercase << std::hex << std::setfill('0')
         << "A:" << std::setw(2) << static_cast<int>(reg.a)
         << " F:" << std::setw(2) << static_cast<int>(reg.f)
@@ -95,22 +314,239 @@ void GB_CPU::printRegsForLog() {
         << " L:" << std::setw(2) << static_cast<int>(reg.l)
         << " SP:" << std::setw(4) << static_cast<int>(reg.sp)
         << " PC:" << std::setw(4) << static_cast<int>(reg.pc)
-        << " PCMEM:" << std::setw(2) << static_cast<int>(memory->read(reg.pc))
-        << "," << std::setw(2) << static_cast<int>(memory->read(reg.pc + 1))
-        << "," << std::setw(2) << static_cast<int>(memory->read(reg.pc + 2))
-        << "," << std::setw(2) << static_cast<int>(memory->read(reg.pc + 3))
+        << " PCMEM:" << std::setw(2) << static_cast<int>(memory.read(reg.pc))
+        << "," << std::setw(2) << static_cast<int>(memory.read(reg.pc + 1))
+        << "," << std::setw(2) << static_cast<int>(memory.read(reg.pc + 2))
+        << "," << std::setw(2) << static_cast<int>(memory.read(reg.pc + 3))
         << std::endl;
 }
 
+void GB_CPU::push(uint16_t value) {
+    reg.sp -= 2;
+    writeWordToMemory(reg.sp, value);
+}
+
+uint16_t GB_CPU::getWordFromMemory(uint16_t address) {
+    return (memory.read(address + 1) << 8) + memory.read(address);
+}
+
+void GB_CPU::writeWordToMemory(uint16_t address, uint16_t value) {
+    memory.write(address + 1, value >> 8); //Write high byte
+    memory.write(address, value & 0xFF); //Write low byte
+}
+
+void GB_CPU::pop(uint16_t &destination) {
+    destination = getWordFromMemory(reg.sp);
+    reg.sp += 2;
+}
+
+void GB_CPU::shift(uint8_t type, uint8_t &operand, uint8_t carryIn) {
+    uint16_t entry = shiftResults[type][operand];
+    operand = entry | carryIn;
+    setResultFlags(operand, entry >> 8);
+}
+
+void GB_CPU::RLC(uint8_t &operand) {
+    shift(0, operand, 0);
+}
+
+void GB_CPU::RRC(uint8_t &operand) {
+    shift(1, operand, 0);
+}
+
+void GB_CPU::RL(uint8_t &operand) {
+    shift(2, operand, carryFlag());
+}
+
+void GB_CPU::RR(uint8_t &operand) {
+    shift(3, operand, carryFlag() << 7);
+}
+
+void GB_CPU::SLA(uint8_t &operand) {
+    shift(4, operand, 0);
+}
+
+void GB_CPU::SRA(uint8_t &operand) {
+    shift(5, operand, 0);
+}
+
+void GB_CPU::SWAP(uint8_t &operand) {
+    shift(6, operand, 0);
+}
+
+void GB_CPU::SRL(uint8_t &operand) {
+    shift(7, operand, 0);
+}
+
+void GB_CPU::BIT(uint8_t bit, uint8_t operand) {
+    //Z set if the bit is 0, N reset, H set, C kept
+    setResultFlags(operand & (1 << bit), 1 << H_FLAG | carryFlag() << C_FLAG);
+}
+
+uint8_t GB_CPU::flags() {
+    uint8_t upper;
+    switch(lazy.kind)
+    {
+        case FLAGS_READY:
+            return reg.f;
+        case FLAGS_RESULT:
+            upper = lazy.fixed;
+            break;
+        default: //FLAGS_ADD and FLAGS_SUB
+            upper = arithmeticFlags[lazy.kind == FLAGS_SUB][lazy.carry][lazy.a & 0xf][lazy.b & 0xf] | carryFlag() << C_FLAG;
+            break;
+    }
+
+    reg.f = (reg.f & 0x0f) | upper | (lazy.result == 0) << Z_FLAG;
+    lazy.kind = FLAGS_READY;
+    return reg.f;
+}
+
+bool GB_CPU::zeroFlag() {
+    if(lazy.kind == FLAGS_READY)
+        return testBit(Z_FLAG, reg.f);
+    return lazy.result == 0;
+}
+
+bool GB_CPU::carryFlag() {
+    switch(lazy.kind)
+    {
+        case FLAGS_READY:
+            return testBit(C_FLAG, reg.f);
+        case FLAGS_RESULT:
+            return testBit(C_FLAG, lazy.fixed);
+        case FLAGS_ADD:
+            return lazy.a + lazy.b + lazy.carry > 0xff;
+        default: //FLAGS_SUB
+            return lazy.a < lazy.b + lazy.carry;
+    }
+}
+
+void GB_CPU::setResultFlags(uint8_t result, uint8_t fixed) {
+    lazy.kind = FLAGS_RESULT;
+    lazy.result = result;
+    lazy.fixed = fixed;
+}
+
+void GB_CPU::setArithmeticFlags(flagKind kind, uint8_t a, uint8_t b, uint8_t carry, uint8_t result) {
+    lazy.kind = kind;
+    lazy.a = a;
+    lazy.b = b;
+    lazy.carry = carry;
+    lazy.result = result;
+}
+
+bool GB_CPU::testBit(uint8_t bit, uint16_t operand) {
+    return (operand & (1 << bit)) >> bit;
+}
+
+void GB_CPU::RES(uint8_t bit, uint8_t &operand) {
+    operand &= ~(1 << bit);
+}
+
+void GB_CPU::SET(uint8_t bit, uint8_t &operand) {
+    operand |= (1 << bit);
+}
+
+void GB_CPU::setMem(uint8_t bit, uint16_t address) {
+    memory.write(address, memory.read(address) | (1 << bit));
+}
+
+void GB_CPU::resMem(uint8_t bit, uint16_t address) {
+    memory.write(address, memory.read(address) & ~(1 << bit));
+}
+
+
+template<uint8_t index>
+uint8_t& GB_CPU::r8() {
+    static_assert(index < 8 && index != 6, "(HL) is not a register");
+    if constexpr (index == 0)
+        return reg.b;
+    else if constexpr (index == 1)
+        return reg.c;
+    else if constexpr (index == 2)
+        return reg.d;
+    else if constexpr (index == 3)
+        return reg.e;
+    else if constexpr (index == 4)
+        return reg.h;
+    else if constexpr (index == 5)
+        return reg.l;
+    else
+        return reg.a;
+}
+
+template<uint8_t index>
+uint8_t GB_CPU::readR8() {
+    if constexpr (index == 6)
+        return memory.read(reg.hl);
+    else
+        return r8<index>();
+}
+
+template<uint8_t index>
+void GB_CPU::writeR8(uint8_t value) {
+    if constexpr (index == 6)
+        memory.write(reg.hl, value);
+    else
+        r8<index>() = value;
+}
+
+template<uint8_t index>
+uint16_t& GB_CPU::r16() {
+    if constexpr (index == 0)
+        return reg.bc;
+    else if constexpr (index == 1)
+        return reg.de;
+    else if constexpr (index == 2)
+        return reg.hl;
+    else
+        return reg.sp;
+}
+
+template<uint8_t index>
+uint16_t& GB_CPU::r16Stack() {
+    if constexpr (index == 3)
+        return reg.af;
+    else
+        return r16<index>();
+}
+
+//Second operand of the 8-bit ALU group, either a register or an immediate byte
+template<uint8_t op>
+uint8_t GB_CPU::aluOperand() {
+    if constexpr ((op & 0xC0) == 0xC0)
+        return memory.read(++reg.pc);
+    else
+        return readR8<op & 0x7>();
+}
+
+template<uint8_t op>
+bool GB_CPU::checkCondition() {
+    switch((op >> 3) & 0x3)
+    {
+        case 0: //Z flag reset
+            return !zeroFlag();
+        case 1: //Z flag set
+            return zeroFlag();
+        case 2: //C flag reset
+            return !carryFlag();
+        default: //C flag set
+            return carryFlag();
+    }
+}
+
+template<uint8_t op>
 void GB_CPU::HALT() {
     halted = true;
 }
 
+template<uint8_t op>
 void GB_CPU::STOP() {
     stopped = true;
-    lastJoypadState = memory->read(JOYPAD);
-    lastLCDState = memory->read(LCDC);
-    lastTimerState = memory->read(TAC);
+    lastJoypadState = memory.read(JOYPAD);
+    lastLCDState = memory.read(LCDC);
+    lastTimerState = memory.read(TAC);
     resMem(BUTTON_ENABLE, JOYPAD); //Enable all buttons
     resMem(DIRECTION_ENABLE, JOYPAD);
     resMem(LCD_ENABLE, LCDC); //Disable LCD
@@ -118,157 +554,75 @@ void GB_CPU::STOP() {
     reg.pc+=2;
 }
 
+template<uint8_t op>
 void GB_CPU::reti() {
-    ret();
+    pop(reg.pc);
     reg.ime = 1;
 }
 
+template<uint8_t op>
 void GB_CPU::ret() {
     pop(reg.pc);
 }
 
+template<uint8_t op>
 void GB_CPU::UNUSED() {
     reg.pc++;
 }
 
+template<uint8_t op>
 void GB_CPU::retcc() {
-    bool jump = false;
-    switch(memory->read(reg.pc))
-    {
-        case 0xC0: //Z flag reset
-            jump = !testBit(Z_FLAG, reg.f);
-            break;
-        case 0xC8: //Z flag set
-            jump = testBit(Z_FLAG, reg.f);
-            break;
-        case 0xD0: //C flag reset
-            jump = !testBit(C_FLAG, reg.f);
-            break;
-        case 0xD8: //C flag set
-            jump = testBit(C_FLAG, reg.f);
-            break;
-    }
-
-    if(jump)
+    if(checkCondition<op>())
     {
         cycles += 12;
-        ret();
+        pop(reg.pc);
         return;
     }
 
     reg.pc++;
 }
 
+template<uint8_t op>
 void GB_CPU::RST() {
     push(reg.pc+1);
-    uint8_t n = 0;
-    switch(memory->read(reg.pc))
-    {
-        case 0xC7:
-            n = 0x00;
-            break;
-        case 0xCF:
-            n = 0x08;
-            break;
-        case 0xD7:
-            n = 0x10;
-            break;
-        case 0xDF:
-            n = 0x18;
-            break;
-        case 0xE7:
-            n = 0x20;
-            break;
-        case 0xEF:
-            n = 0x28;
-            break;
-        case 0xF7:
-            n = 0x30;
-            break;
-        case 0xFF:
-            n = 0x38;
-            break;
-    }
-
-    reg.pc = MEMORY_BEGIN + n;
-}
-
-void GB_CPU::push(uint16_t value) {
-    reg.sp -= 2;
-    writeWordToMemory(reg.sp, value);
-}
-
-uint16_t GB_CPU::getWordFromMemory(uint16_t address) {
-    return (memory->read(address + 1) << 8) + memory->read(address);
-}
-
-void GB_CPU::writeWordToMemory(uint16_t address, uint16_t value) {
-    memory->write(address + 1, value >> 8); //Write high byte
-    memory->write(address, value & 0xFF); //Write low byte
-}
-
-void GB_CPU::pop(uint16_t &destination) {
-    destination = getWordFromMemory(reg.sp);
-    reg.sp += 2;
+    reg.pc = MEMORY_BEGIN + (op & 0x38);
 }
 
+template<uint8_t op>
 void GB_CPU::nop() {
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::pushNN() {
-    uint16_t value;
-    switch(memory->read(reg.pc))
-    {
-        case 0xF5:
-            value = reg.af;
-            break;
-        case 0xC5:
-            value = reg.bc;
-            break;
-        case 0xD5:
-            value = reg.de;
-            break;
-        case 0xE5:
-            value = reg.hl;
-            break;
-    }
-    push(value);
+    if constexpr (((op >> 4) & 0x3) == 3) //PUSH AF
+        flags();
+    push(r16Stack<(op >> 4) & 0x3>());
     reg.pc++;
 }
 
+template<uint8_t op>
 void GB_CPU::popNN() {
-    uint16_t * destination = nullptr;
-    switch(memory->read(reg.pc))
-    {
-        case 0xF1:
-            destination = &reg.af;
-            break;
-        case 0xC1:
-            destination = &reg.bc;
-            break;
-        case 0xD1:
-            destination = &reg.de;
-            break;
-        case 0xE1:
-            destination = &reg.hl;
-            break;
-    }
-
-    pop(*destination);
+    pop(r16Stack<(op >> 4) & 0x3>());
+    if constexpr (((op >> 4) & 0x3) == 3) //POP AF
+        lazy.kind = FLAGS_READY;
     reg.f &= 0xf0;
     reg.pc++;
 }
 
+template<uint8_t op>
 void GB_CPU::JPHL() {
     reg.pc = reg.hl;
 }
 
+template<uint8_t op>
 void GB_CPU::JPnn() {
     reg.pc = getWordFromMemory(reg.pc + 1);
 }
 
+template<uint8_t op>
 void GB_CPU::CCF() {
+    flags();
     RES(N_FLAG,reg.f);
     RES(H_FLAG,reg.f);
 
@@ -279,156 +633,68 @@ void GB_CPU::CCF() {
     reg.pc++;
 }
 
+template<uint8_t op>
 void GB_CPU::CB() {
     reg.pc++;
-    uint8_t * operand = nullptr;
-    uint8_t tempHL = memory->read(reg.hl);
-    bool HL = false;
-    switch(memory->read(reg.pc) & 0x0F) //Check lower nibble for operand
-    {
-        case 0x0:
-        case 0x8:
-            operand = &reg.b;
-            break;
-        case 0x1:
-        case 0x9:
-            operand = &reg.c;
-            break;
-        case 0x2:
-        case 0xA:
-            operand = &reg.d;
-            break;
-        case 0x3:
-        case 0xB:
-            operand = &reg.e;
-            break;
-        case 0x4:
-        case 0xC:
-            operand = &reg.h;
-            break;
-        case 0x5:
-        case 0xD:
-            operand = &reg.l;
-            break;
-        case 0x6:
-        case 0xE:
-            operand = &tempHL;
-            HL = true;
-            break;
-        case 0x7:
-        case 0xF:
-            operand = &reg.a;
-            break;
-    }
+    (this->*cbInstructions[memory.read(reg.pc)])();
+    reg.pc++;
+}
 
-    switch(memory->read(reg.pc))
-    {
-        case 0x00 ... 0x07:
-            RLC(*operand);
-            break;
-        case 0x08 ... 0x0F:
-            RRC(*operand);
-            break;
-        case 0x10 ... 0x17:
-            RL(*operand);
-            break;
-        case 0x18 ... 0x1F:
-            RR(*operand);
-            break;
-        case 0x20 ... 0x27:
-            SLA(*operand);
-            break;
-        case 0x28 ... 0x2F:
-            SRA(*operand);
-            break;
-        case 0x30 ... 0x37:
-            SWAP(*operand);
-            break;
-        case 0x38 ... 0x3F:
-            SRL(*operand);
-            break;
-        case 0x40 ... 0x47:
-            BIT(0,*operand);
-            break;
-        case 0x48 ... 0x4F:
-            BIT(1,*operand);
-            break;
-        case 0x50 ... 0x57:
-            BIT(2,*operand);
-            break;
-        case 0x58 ... 0x5F:
-            BIT(3,*operand);
-            break;
-        case 0x60 ... 0x67:
-            BIT(4,*operand);
-            break;
-        case 0x68 ... 0x6F:
-            BIT(5,*operand);
-            break;
-        case 0x70 ... 0x77:
-            BIT(6,*operand);
-            break;
-        case 0x78 ... 0x7F:
-            BIT(7,*operand);
-            break;
-        case 0x80 ... 0x87:
-            RES(0,*operand);
-            break;
-        case 0x88 ... 0x8F:
-            RES(1,*operand);
-            break;
-        case 0x90 ... 0x97:
-            RES(2,*operand);
-            break;
-        case 0x98 ... 0x9F:
-            RES(3,*operand);
-            break;
-        case 0xA0 ... 0xA7:
-            RES(4,*operand);
-            break;
-        case 0xA8 ... 0xAF:
-            RES(5,*operand);
-            break;
-        case 0xB0 ... 0xB7:
-            RES(6,*operand);
-            break;
-        case 0xB8 ... 0xBF:
-            RES(7,*operand);
-            break;
-        case 0xC0 ... 0xC7:
-            SET(0,*operand);
-            break;
-        case 0xC8 ... 0xCF:
-            SET(1,*operand);
-            break;
-        case 0xD0 ... 0xD7:
-            SET(2,*operand);
-            break;
-        case 0xD8 ... 0xDF:
-            SET(3,*operand);
-            break;
-        case 0xE0 ... 0xE7:
-            SET(4,*operand);
+template<uint8_t op>
+void GB_CPU::CBop() {
+    //Lower 3 bits select the operand, the rest select the operation
+    constexpr uint8_t index = op & 0x7;
+    constexpr uint8_t bit = (op >> 3) & 0x7;
+    uint8_t operand = readR8<index>();
+
+    switch(op >> 6)
+    {
+        case 0:
+            switch(bit)
+            {
+                case 0:
+                    RLC(operand);
+                    break;
+                case 1:
+                    RRC(operand);
+                    break;
+                case 2:
+                    RL(operand);
+                    break;
+                case 3:
+                    RR(operand);
+                    break;
+                case 4:
+                    SLA(operand);
+                    break;
+                case 5:
+                    SRA(operand);
+                    break;
+                case 6:
+                    SWAP(operand);
+                    break;
+                case 7:
+                    SRL(operand);
+                    break;
+            }
             break;
-        case 0xE8 ... 0xEF:
-            SET(5,*operand);
+        case 1:
+            BIT(bit, operand);
             break;
-        case 0xF0 ... 0xF7:
-            SET(6,*operand);
+        case 2:
+            RES(bit, operand);
             break;
-        case 0xF8 ... 0xFF:
-            SET(7,*operand);
+        case 3:
+            SET(bit, operand);
             break;
     }
 
-    if(HL)
-        memory->write(reg.hl, tempHL);
-
-    reg.pc++;
+    writeR8<index>(operand);
 }
 
+template<uint8_t op>
 void GB_CPU::CBA() {
-    switch(memory->read(reg.pc))
+    switch(op)
     {
         case 0x07:
             RLC(reg.a);
@@ -442,486 +708,109 @@ void GB_CPU::CBA() {
         case 0x1F:
             RR(reg.a);
     }
-    RES(Z_FLAG,reg.f);
+    //Same flags as the prefixed rotate, but Z is always reset
+    reg.f = (reg.f & 0x0f) | lazy.fixed;
+    lazy.kind = FLAGS_READY;
     reg.pc++;
 }
 
-void GB_CPU::RLC(uint8_t &operand) {
-    bool newBit0 = testBit(7,operand);
-    bool newCarry = testBit(7,operand);
+template<uint8_t op>
+void GB_CPU::SCF() {
+    flags();
+    RES(N_FLAG,reg.f);
+    RES(H_FLAG,reg.f);
+    SET(C_FLAG,reg.f);
+    reg.pc++;
+}
 
-    operand = operand << 1;
-    operand += newBit0;
-    RES(C_FLAG,reg.f);
-    if(newCarry)
-        SET(C_FLAG,reg.f);
+template<uint8_t op>
+void GB_CPU::DAA() {
+    uint16_t entry = daaResults[(flags() >> C_FLAG) & 0x7][reg.a];
+    reg.a = entry;
+    reg.f = (reg.f & 0x0f) | entry >> 8;
 
-    RES(N_FLAG,reg.f); //Reset N and H flags
-    RES(H_FLAG,reg.f);
+    reg.pc++;
+}
 
-    if(operand == 0) //Set Z flag
+template<uint8_t op>
+void GB_CPU::JPccnn() {
+    if(checkCondition<op>())
     {
-        SET(Z_FLAG,reg.f);
+        reg.pc = getWordFromMemory(reg.pc + 1);
+        cycles += 4;
     }
     else
     {
-        RES(Z_FLAG,reg.f);
+        reg.pc += 3;
     }
 }
 
-void GB_CPU::RRC(uint8_t &operand) {
-    uint8_t newBit7 = testBit(0,operand) << 7;
-    bool newCarry = testBit(0,operand) << C_FLAG;
-
-    operand = operand >> 1;
-    operand += newBit7;
-    RES(C_FLAG,reg.f);
-    if(newCarry)
-        SET(C_FLAG,reg.f);
+template<uint8_t op>
+void GB_CPU::JRccn() {
+    bool jump;
+    if constexpr (op == 0x18)
+        jump = true;
+    else
+        jump = checkCondition<op>();
 
-    RES(N_FLAG,reg.f); //Reset N and H flags
-    RES(H_FLAG,reg.f);
+    reg.pc += 2;
 
-    if(operand == 0) //Set Z flag
-    {
-        SET(Z_FLAG,reg.f);
-    }
-    else
+    if(jump)
     {
-        RES(Z_FLAG,reg.f);
+        int8_t finalValue = memory.read(reg.pc - 1);
+        reg.pc += finalValue;
+        cycles += 4;
     }
 }
 
-void GB_CPU::RL(uint8_t &operand) {
-    uint8_t newBit0 = testBit(C_FLAG,reg.f);
-    bool newCarry = testBit(7,operand);
-
-    operand = operand << 1;
-    operand += newBit0;
-    RES(C_FLAG,reg.f);
-    if(newCarry)
-        SET(C_FLAG,reg.f);
+template<uint8_t op>
+void GB_CPU::INC() {
+    constexpr uint8_t index = (op >> 3) & 0x7;
+    uint8_t value = readR8<index>() + 1;
 
-    RES(N_FLAG,reg.f); //Reset N and H flags
-    RES(H_FLAG,reg.f);
+    //H set if the low nibble overflowed, N reset, C kept
+    setResultFlags(value, stepFlags[0][value & 0xf] | carryFlag() << C_FLAG);
 
-    if(operand == 0) //Set Z flag
-    {
-        SET(Z_FLAG,reg.f);
-    }
-    else
-    {
-        RES(Z_FLAG,reg.f);
-    }
-}
-
-void GB_CPU::RR(uint8_t &operand) {
-    uint8_t newBit7 = testBit(C_FLAG,reg.f) << 7;
-    bool newCarry = testBit(0,operand);
-
-    operand = operand >> 1;
-    operand += newBit7;
-    RES(C_FLAG,reg.f);
-    if(newCarry)
-        SET(C_FLAG,reg.f);
-
-    RES(N_FLAG,reg.f); //Reset N and H flags
-    RES(H_FLAG,reg.f);
-
-    if(operand == 0) //Set Z flag
-    {
-        SET(Z_FLAG,reg.f);
-    }
-    else
-    {
-        RES(Z_FLAG,reg.f);
-    }
-}
-
-void GB_CPU::SLA(uint8_t &operand) {
-    if(testBit(7,operand))
-        SET(C_FLAG,reg.f);
-    else
-        RES(C_FLAG,reg.f);//Set C flag to bit 7 of operand
-
-    RES(N_FLAG,reg.f); //Reset N and H flags
-    RES(H_FLAG,reg.f);
-
-    operand = operand << 1;
-
-    if(operand == 0) //Set Z flag
-    {
-        SET(Z_FLAG,reg.f);
-    }
-    else
-    {
-        RES(Z_FLAG,reg.f);
-    }
-}
-
-void GB_CPU::SRA(uint8_t &operand) {
-    uint8_t msb = operand & (1 << 7);
-    if(testBit(0,operand))
-        SET(C_FLAG,reg.f);
-    else
-        RES(C_FLAG,reg.f);//Set c flag to bit 0 of operand
-
-    RES(N_FLAG,reg.f); //Reset N and H flags
-    RES(H_FLAG,reg.f);
-
-    operand = operand >> 1;
-    operand += msb;
-
-    if(operand == 0) //Set Z flag
-    {
-        SET(Z_FLAG,reg.f);
-    }
-    else
-    {
-        RES(Z_FLAG,reg.f);
-    }
-}
-
-void GB_CPU::SWAP(uint8_t &operand) {
-    operand = (operand << 4) + ((operand & 0xF0) >> 4);
-    if(operand == 0)
-        SET(Z_FLAG,reg.f);
-    else
-        RES(Z_FLAG,reg.f);
-
-    RES(N_FLAG,reg.f);
-    RES(H_FLAG,reg.f);
-    RES(C_FLAG,reg.f);
-}
-
-void GB_CPU::SRL(uint8_t &operand) {
-    if(testBit(0,operand))
-        SET(C_FLAG,reg.f);
-    else
-        RES(C_FLAG,reg.f); //Set C flag to bit 0 of operand
-
-    RES(N_FLAG,reg.f); //Reset N and H flags
-    RES(H_FLAG,reg.f);
-
-    operand = operand >> 1;
-
-    if(operand == 0) //Set Z flag
-    {
-        SET(Z_FLAG,reg.f);
-    }
-    else
-    {
-        RES(Z_FLAG,reg.f);
-    }
-}
-
-void GB_CPU::BIT(uint8_t bit, uint8_t operand) {
-    RES(N_FLAG,reg.f);
-    SET(H_FLAG,reg.f);
-
-    if(testBit(bit, operand)) //If bit of operand is not 0
-    {
-        RES(Z_FLAG,reg.f);
-    }
-    else //Bit is 0
-    {
-        SET(Z_FLAG,reg.f);
-    }
-}
-
-bool GB_CPU::testBit(uint8_t bit, uint16_t operand) {
-    return (operand & (1 << bit)) >> bit;
-}
-
-void GB_CPU::RES(uint8_t bit, uint8_t &operand) {
-    operand &= ~(1 << bit);
-}
-
-void GB_CPU::SET(uint8_t bit, uint8_t &operand) {
-    operand |= (1 << bit);
-}
-
-void GB_CPU::setMem(uint8_t bit, uint16_t address) {
-    memory->write(address, memory->read(address) | (1 << bit));
-}
-
-void GB_CPU::resMem(uint8_t bit, uint16_t address) {
-    memory->write(address, memory->read(address) & ~(1 << bit));
-}
-
-void GB_CPU::SCF() {
-    RES(N_FLAG,reg.f);
-    RES(H_FLAG,reg.f);
-    SET(C_FLAG,reg.f);
-    reg.pc++;
-}
-
-void GB_CPU::DAA() {
-    uint8_t offset = 0;
-
-    // Check for digits > 9
-    if (
-        testBit(H_FLAG,reg.f) ||
-        (!testBit(N_FLAG,reg.f) &&(reg.a & 0x0f) > 0x09)
-    ) {
-        offset |= 0x6;
-    }
-    if (
-        testBit(C_FLAG,reg.f) ||
-        (!testBit(N_FLAG,reg.f) && reg.a > 0x99)
-    ) {
-        offset |= 0x60;
-        SET(C_FLAG,reg.f);
-    }
-
-    // Add or subtract if last operation was addition/subtraction
-    if (!testBit(N_FLAG,reg.f)) {
-        reg.a += offset;
-    } else {
-        reg.a -= offset;
-    }
-
-    // Set flags
-    RES(H_FLAG,reg.f);
-    if(reg.a == 0) {
-        SET(Z_FLAG,reg.f);
-    } else {
-        RES(Z_FLAG,reg.f);
-    }
-
-    reg.pc++;
-}
-
-void GB_CPU::JPccnn() {
-    bool jump = false;
-    switch(memory->read(reg.pc))
-    {
-        case 0xC2: //Z flag reset
-            jump = !testBit(Z_FLAG,reg.f);
-            break;
-        case 0xCA: //Z flag set
-            jump = testBit(Z_FLAG,reg.f);
-            break;
-        case 0xD2: //C flag reset
-            jump = !testBit(C_FLAG,reg.f);
-            break;
-        case 0xDA: //C flag set
-            jump = testBit(C_FLAG,reg.f);
-            break;
-    }
-
-    if(jump)
-    {
-        reg.pc = getWordFromMemory(reg.pc + 1);
-        cycles += 4;
-    }
-    else
-    {
-        reg.pc += 3;
-    }
-
-}
-
-void GB_CPU::JRccn() {
-    bool jump = false;
-    switch(memory->read(reg.pc))
-    {
-        case 0x20: //Z flag reset
-            jump = !testBit(Z_FLAG,reg.f);
-            break;
-        case 0x28: //Z flag set
-            jump = testBit(Z_FLAG,reg.f);
-            break;
-        case 0x30: //C flag reset
-            jump = !testBit(C_FLAG,reg.f);
-            break;
-        case 0x38: //C flag set
-            jump = testBit(C_FLAG,reg.f);
-            break;
-        case 0x18:
-            jump = true;
-            break;
-    }
-
-    reg.pc += 2;
-
-    if(jump)
-    {
-        int8_t finalValue = memory->read(reg.pc - 1);
-        reg.pc += finalValue;
-        cycles += 4;
-    }
-}
-
-void GB_CPU::INC() {
-    uint8_t* r;
-    uint8_t tempHL = memory->read(reg.hl);
-    bool HL = false;
-    switch (memory->read(reg.pc))
-    {
-        case 0x3C:
-            r = &reg.a;
-            break;
-        case 0x04:
-            r = &reg.b;
-            break;
-        case 0x0C:
-            r = &reg.c;
-            break;
-        case 0x14:
-            r = &reg.d;
-            break;
-        case 0x1c:
-            r = &reg.e;
-            break;
-        case 0x24:
-            r = &reg.h;
-            break;
-        case 0x2c:
-            r = &reg.l;
-            break;
-        case 0x34:
-            r = &tempHL;
-            HL = true;
-            break;
-    }
-
-    if ((*r & 0xf) + 1 > 0xf) //Check for half carry
-    {
-        SET(H_FLAG,reg.f); //Set H Flag
-    }
-    else
-    {
-        RES(H_FLAG,reg.f); //Clear H Flag
-    }
-
-    (*r)++;
-
-    RES(N_FLAG,reg.f); //Clear N Flag
-    if (*r == 0)
-        SET(Z_FLAG,reg.f); //Set Z Flag
-    else
-        RES(Z_FLAG,reg.f); //Clear Z Flag
-
-    if(HL)
-        memory->write(reg.hl, tempHL);
+    writeR8<index>(value);
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::INC16() {
-    uint16_t* r;
-    switch(memory->read(reg.pc))
-    {
-        case 0x03:
-            r = &reg.bc;
-            break;
-        case 0x13:
-            r = &reg.de;
-            break;
-        case 0x23:
-            r = &reg.hl;
-            break;
-        case 0x33:
-            r = &reg.sp;
-            break;
-    }
-
-    (*r)++;
-
+    r16<(op >> 4) & 0x3>()++;
     reg.pc++;
 }
 
+template<uint8_t op>
 void GB_CPU::DEC() {
-    uint8_t* r;
-    uint8_t tempHL = memory->read(reg.hl);
-    bool HL = false;
-    switch (memory->read(reg.pc))
-    {
-        case 0x3D:
-            r = &reg.a;
-            break;
-        case 0x05:
-            r = &reg.b;
-            break;
-        case 0x0D:
-            r = &reg.c;
-            break;
-        case 0x15:
-            r = &reg.d;
-            break;
-        case 0x1D:
-            r = &reg.e;
-            break;
-        case 0x25:
-            r = &reg.h;
-            break;
-        case 0x2D:
-            r = &reg.l;
-            break;
-        case 0x35:
-            r = &tempHL;
-            HL = true;
-            break;
-    }
-
-    if ((*r & 0xf) - 1 < 0) //Check for half carry
-    {
-        SET(H_FLAG,reg.f); //Set H Flag
-    }
-    else
-    {
-        RES(H_FLAG,reg.f); //Clear H Flag
-    }
+    constexpr uint8_t index = (op >> 3) & 0x7;
+    uint8_t value = readR8<index>() - 1;
 
-    (*r)--;
+    //H set if the low nibble borrowed, N set, C kept
+    setResultFlags(value, stepFlags[1][value & 0xf] | carryFlag() << C_FLAG);
 
-    SET(N_FLAG,reg.f); //Set N Flag
-    if (*r == 0)
-    {
-        SET(Z_FLAG,reg.f); //Set Z Flag
-    }
-    else
-    {
-        RES(Z_FLAG,reg.f); //Clear Z Flag
-    }
-
-    if(HL)
-        memory->write(reg.hl, tempHL);
+    writeR8<index>(value);
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::DEC16() {
-    uint16_t* r;
-    switch (memory->read(reg.pc))
-    {
-        case 0x0b:
-            r = &reg.bc;
-            break;
-        case 0x1b:
-            r = &reg.de;
-            break;
-        case 0x2b:
-            r = &reg.hl;
-            break;
-        case 0x3b:
-            r = &reg.sp;
-            break;
-    }
-
-    (*r)--;
-
+    r16<(op >> 4) & 0x3>()--;
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::LDnnSP() {
     uint16_t address = getWordFromMemory(reg.pc + 1);
     writeWordToMemory(address,reg.sp);
     reg.pc += 3;
 }
 
+template<uint8_t op>
 void GB_CPU::ADDSPr8() {
-    int8_t value = memory->read(reg.pc + 1);
-    uint8_t unsignedValue = memory->read(reg.pc + 1);
+    flags();
+    int8_t value = memory.read(reg.pc + 1);
+    uint8_t unsignedValue = value;
     uint16_t finalValue = reg.sp + value;
 
     if((reg.sp & 0xff) + unsignedValue > 0xff)
@@ -950,9 +839,11 @@ void GB_CPU::ADDSPr8() {
     reg.pc += 2;
 }
 
+template<uint8_t op>
 void GB_CPU::LDHLSPn() {
-    int8_t value = memory->read(reg.pc + 1);
-    uint8_t unsignedValue = memory->read(reg.pc + 1);
+    flags();
+    int8_t value = memory.read(reg.pc + 1);
+    uint8_t unsignedValue = value;
     uint16_t finalValue = reg.sp + value;
 
     if((reg.sp & 0xff) + unsignedValue > 0xff)
@@ -981,493 +872,103 @@ void GB_CPU::LDHLSPn() {
     reg.pc += 2;
 }
 
+template<uint8_t op>
 void GB_CPU::LDr1r2() {
-    uint8_t* source = nullptr;
-    uint8_t* destination = nullptr;
-    uint16_t location = getWordFromMemory(reg.pc + 1);
-    uint16_t writeLocation = reg.hl;
-    uint8_t imm = memory->read(reg.pc + 1);
-    uint8_t tempMem = memory->read(reg.hl);
-    bool writingToMemory = false;
-    bool writingToLocation = false;
-    switch (memory->read(reg.pc))
+    switch(op)
     {
-        case 0x7F:
-            source = &reg.a;
-            destination = &reg.a;
-            break;
-        case 0x78:
-            source = &reg.b;
-            destination = &reg.a;
-            break;
-        case 0x79:
-            source = &reg.c;
-            destination = &reg.a;
-            break;
-        case 0x7A:
-            source = &reg.d;
-            destination = &reg.a;
-            break;
-        case 0x7B:
-            source = &reg.e;
-            destination = &reg.a;
-            break;
-        case 0x7C:
-            source = &reg.h;
-            destination = &reg.a;
-            break;
-        case 0x7D:
-            source = &reg.l;
-            destination = &reg.a;
-            break;
-        case 0x7E:
-            source = &tempMem;
-            destination = &reg.a;
-            break;
-
-        case 0x40:
-            source = &reg.b;
-            destination = &reg.b;
-            break;
-        case 0x41:
-            source = &reg.c;
-            destination = &reg.b;
-            break;
-        case 0x42:
-            source = &reg.d;
-            destination = &reg.b;
-            break;
-        case 0x43:
-            source = &reg.e;
-            destination = &reg.b;
-            break;
-        case 0x44:
-            source = &reg.h;
-            destination = &reg.b;
-            break;
-        case 0x45:
-            source = &reg.l;
-            destination = &reg.b;
-            break;
-        case 0x46:
-            source = &tempMem;
-            destination = &reg.b;
-            break;
-
-        case 0x48:
-            source = &reg.b;
-            destination = &reg.c;
-            break;
-        case 0x49:
-            source = &reg.c;
-            destination = &reg.c;
-            break;
-        case 0x4A:
-            source = &reg.d;
-            destination = &reg.c;
-            break;
-        case 0x4B:
-            source = &reg.e;
-            destination = &reg.c;
-            break;
-        case 0x4C:
-            source = &reg.h;
-            destination = &reg.c;
-            break;
-        case 0x4D:
-            source = &reg.l;
-            destination = &reg.c;
-            break;
-        case 0x4E:
-            source = &tempMem;
-            destination = &reg.c;
-            break;
-
-        case 0x50:
-            source = &reg.b;
-            destination = &reg.d;
-            break;
-        case 0x51:
-            source = &reg.c;
-            destination = &reg.d;
-            break;
-        case 0x52:
-            source = &reg.d;
-            destination = &reg.d;
-            break;
-        case 0x53:
-            source = &reg.e;
-            destination = &reg.d;
-            break;
-        case 0x54:
-            source = &reg.h;
-            destination = &reg.d;
-            break;
-        case 0x55:
-            source = &reg.l;
-            destination = &reg.d;
-            break;
-        case 0x56:
-            source = &tempMem;
-            destination = &reg.d;
-            break;
-
-        case 0x58:
-            source = &reg.b;
-            destination = &reg.e;
-            break;
-        case 0x59:
-            source = &reg.c;
-            destination = &reg.e;
-            break;
-        case 0x5A:
-            source = &reg.d;
-            destination = &reg.e;
+        case 0x02: //LD (BC),A
+            memory.write(reg.bc, reg.a);
             break;
-        case 0x5B:
-            source = &reg.e;
-            destination = &reg.e;
+        case 0x12: //LD (DE),A
+            memory.write(reg.de, reg.a);
             break;
-        case 0x5C:
-            source = &reg.h;
-            destination = &reg.e;
+        case 0x0A: //LD A,(BC)
+            reg.a = memory.read(reg.bc);
             break;
-        case 0x5D:
-            source = &reg.l;
-            destination = &reg.e;
+        case 0x1A: //LD A,(DE)
+            reg.a = memory.read(reg.de);
             break;
-        case 0x5E:
-            source = &tempMem;
-            destination = &reg.e;
-            break;
-
-        case 0x60:
-            source = &reg.b;
-            destination = &reg.h;
-            break;
-        case 0x61:
-            source = &reg.c;
-            destination = &reg.h;
-            break;
-        case 0x62:
-            source = &reg.d;
-            destination = &reg.h;
-            break;
-        case 0x63:
-            source = &reg.e;
-            destination = &reg.h;
-            break;
-        case 0x64:
-            source = &reg.h;
-            destination = &reg.h;
-            break;
-        case 0x65:
-            source = &reg.l;
-            destination = &reg.h;
-            break;
-        case 0x66:
-            source = &tempMem;
-            destination = &reg.h;
-            break;
-
-        case 0x68:
-            source = &reg.b;
-            destination = &reg.l;
-            break;
-        case 0x69:
-            source = &reg.c;
-            destination = &reg.l;
-            break;
-        case 0x6A:
-            source = &reg.d;
-            destination = &reg.l;
-            break;
-        case 0x6B:
-            source = &reg.e;
-            destination = &reg.l;
-            break;
-        case 0x6C:
-            source = &reg.h;
-            destination = &reg.l;
-            break;
-        case 0x6D:
-            source = &reg.l;
-            destination = &reg.l;
-            break;
-        case 0x6E:
-            source = &tempMem;
-            destination = &reg.l;
-            break;
-
-        case 0x70:
-            source = &reg.b;
-            destination = &tempMem;
-            writingToMemory = true;
-            break;
-        case 0x71:
-            source = &reg.c;
-            destination = &tempMem;
-            writingToMemory = true;
-            break;
-        case 0x72:
-            source = &reg.d;
-            destination = &tempMem;
-            writingToMemory = true;
-            break;
-        case 0x73:
-            source = &reg.e;
-            destination = &tempMem;
-            writingToMemory = true;
-            break;
-        case 0x74:
-            source = &reg.h;
-            destination = &tempMem;
-            writingToMemory = true;
-            break;
-        case 0x75:
-            source = &reg.l;
-            destination = &tempMem;
-            writingToMemory = true;
-            break;
-        case 0x36:
-            source = &imm;
-            destination = &tempMem;
-            writingToMemory = true;
+        case 0x36: //LD (HL),n
+            memory.write(reg.hl, memory.read(reg.pc + 1));
             reg.pc += 1;
             break;
-
-            //LD n,A cases
-        case 0x47:
-            source = &reg.a;
-            destination = &reg.b;
-            break;
-        case 0x4F:
-            source = &reg.a;
-            destination = &reg.c;
-            break;
-        case 0x57:
-            source = &reg.a;
-            destination = &reg.d;
-            break;
-        case 0x5F:
-            source = &reg.a;
-            destination = &reg.e;
-            break;
-        case 0x67:
-            source = &reg.a;
-            destination = &reg.h;
-            break;
-        case 0x6F:
-            source = &reg.a;
-            destination = &reg.l;
-            break;
-        case 0x02:
-            source = &reg.a;
-            tempMem = memory->read(reg.bc);
-            destination = &tempMem;
-            writingToMemory = true;
-            writeLocation = reg.bc;
-            break;
-        case 0x12:
-            source = &reg.a;
-            tempMem = memory->read(reg.de);
-            destination = &tempMem;
-            writingToMemory = true;
-            writeLocation = reg.de;
-            break;
-        case 0x77:
-            source = &reg.a;
-            destination = &tempMem;
-            writingToMemory = true;
+        case 0x3E: //LD A,n
+            reg.a = memory.read(reg.pc + 1);
+            reg.pc += 1;
             break;
-        case 0xEA:
-        {
-
-            source = &reg.a;
-            tempMem = memory->read(location);
-            destination = &tempMem;
-            writingToMemory = true;
-            writeLocation = location;
+        case 0xEA: //LD (nn),A
+            memory.write(getWordFromMemory(reg.pc + 1), reg.a);
             reg.pc += 2;
-        }
-            break;
-
-            //LD A,n cases
-        case 0x0A:
-            tempMem = memory->read(reg.bc);
-            source = &tempMem;
-            destination = &reg.a;
             break;
-        case 0x1A:
-            tempMem = memory->read(reg.de);
-            source = &tempMem;
-            destination = &reg.a;
-            break;
-        case 0xFA:
-        {
-            tempMem = memory->read(location);
-            source = &tempMem;
-            destination = &reg.a;
+        case 0xFA: //LD A,(nn)
+            reg.a = memory.read(getWordFromMemory(reg.pc + 1));
             reg.pc += 2;
-        }
             break;
-        case 0x3E:
-            source = &imm;
-            destination = &reg.a;
-            reg.pc++;
+        case 0xE0: //LDH (n),A
+            memory.write(0xFF00 + memory.read(reg.pc + 1), reg.a);
+            reg.pc += 1;
             break;
-
-            //LDH Cases
-        case 0xE0:
-            source = &reg.a;
-            tempMem = memory->read(0xFF00 + imm);
-            destination = &tempMem;
-            writingToMemory = true;
-            writeLocation = 0xFF00 + imm;
-            reg.pc++;
+        case 0xF0: //LDH A,(n)
+            reg.a = memory.read(0xFF00 + memory.read(reg.pc + 1));
+            reg.pc += 1;
             break;
-        case 0xF0:
-            tempMem = memory->read(0xFF00 + imm);
-            source = &tempMem;
-            destination = &reg.a;
-            reg.pc++;
+        case 0xE2: //LD (C),A
+            memory.write(0xFF00 + reg.c, reg.a);
             break;
-        case 0xE2:
-            source = &reg.a;
-            tempMem = memory->read(0xFF00 + reg.c);
-            destination = &tempMem;
-            writingToMemory = true;
-            writeLocation = 0xFF00 + reg.c;
+        case 0xF2: //LD A,(C)
+            reg.a = memory.read(0xFF00 + reg.c);
             break;
-        case 0xF2:
-            tempMem = memory->read(0xFF00 + reg.c);
-            source = &tempMem;
-            destination = &reg.a;
+        default: //LD r1,r2 - 0x40 to 0x7F
+            writeR8<(op >> 3) & 0x7>(readR8<op & 0x7>());
             break;
     }
 
-    *destination = *source;
-
-    if(writingToMemory)
-    {
-        memory->write(writeLocation, tempMem);
-    }
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::LDSPHL() {
     reg.sp = reg.hl;
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::LDI() {
-    uint8_t* source;
-    uint8_t* destination;
-
-    uint8_t tempHL = memory->read(reg.hl);
-    bool writing = false;
-
-    switch(memory->read(reg.pc))
-    {
-        case 0x2A:
-            source = &tempHL;
-            destination = &reg.a;
-            break;
-        case 0x22:
-            source = &reg.a;
-            destination = &tempHL;
-            writing = true;
-            break;
-    }
-
-    *destination = *source;
-
-    if(writing)
-        memory->write(reg.hl,tempHL);
+    if constexpr (op == 0x2A)
+        reg.a = memory.read(reg.hl);
+    else
+        memory.write(reg.hl, reg.a);
 
     reg.hl++;
 
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::LDnnN() {
-    uint8_t* destination = nullptr;
-    switch(memory->read(reg.pc))
-    {
-        case 0x06:
-            destination = &reg.b;
-            break;
-        case 0x0E:
-            destination = &reg.c;
-            break;
-        case 0x16:
-            destination = &reg.d;
-            break;
-        case 0x1E:
-            destination = &reg.e;
-            break;
-        case 0x26:
-            destination = &reg.h;
-            break;
-        case 0x2E:
-            destination = &reg.l;
-            break;
-    }
-
-    *destination = memory->read(reg.pc + 1);
+    writeR8<(op >> 3) & 0x7>(memory.read(reg.pc + 1));
     reg.pc += 2;
 }
 
+template<uint8_t op>
 void GB_CPU::LDD() {
-    uint8_t* source;
-    uint8_t* destination;
-
-    uint8_t tempHL = memory->read(reg.hl);
-    bool writing = false;
-
-    switch(memory->read(reg.pc))
-    {
-        case 0x32:
-            destination = &tempHL;
-            writing = true;
-            source = &reg.a;
-            break;
-        case 0x3A:
-            source = &tempHL;
-            destination = &reg.a;
-            break;
-    }
-
-    *destination = *source;
-
-    if(writing)
-        memory->write(reg.hl,tempHL);
+    if constexpr (op == 0x3A)
+        reg.a = memory.read(reg.hl);
+    else
+        memory.write(reg.hl, reg.a);
 
     reg.hl--;
 
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::CAL() {
-    bool branch = 0;
-    switch (memory->read(reg.pc))
-    {
-        case 0xC4: //Z flag reset
-            branch = !testBit(Z_FLAG,reg.f);
-            break;
-        case 0xCC: //Z flag set
-            branch = testBit(Z_FLAG,reg.f);
-            break;
-        case 0xD4: //C flag reset
-            branch = !testBit(C_FLAG,reg.f);
-            break;
-        case 0xDC: //C flag set
-            branch = testBit(C_FLAG,reg.f);
-            break;
-        case 0xCD:
-            branch = true;
-            break;
-    }
+    bool branch;
+    if constexpr (op == 0xCD)
+        branch = true;
+    else
+        branch = checkCondition<op>();
 
     if (branch)
     {
@@ -1481,497 +982,112 @@ void GB_CPU::CAL() {
     }
 }
 
+template<uint8_t op>
 void GB_CPU::OR() {
-    uint8_t value;
-    switch (memory->read(reg.pc))
-    {
-        case 0xB7:
-            value = reg.a;
-            break;
-        case 0xB0:
-            value = reg.b;
-            break;
-        case 0xB1:
-            value = reg.c;
-            break;
-        case 0xB2:
-            value = reg.d;
-            break;
-        case 0xB3:
-            value = reg.e;
-            break;
-        case 0xB4:
-            value = reg.h;
-            break;
-        case 0xB5:
-            value = reg.l;
-            break;
-        case 0xB6:
-            value = memory->read(reg.hl);
-            break;
-        case 0xF6:
-            value = memory->read(reg.pc + 1);
-            reg.pc += 1;
-            break;
-    }
-
-    reg.a |= value;
-
-    if (reg.a == 0)
-        SET(Z_FLAG,reg.f);
-    else
-        RES(Z_FLAG,reg.f);
-
-    RES(N_FLAG,reg.f);
-    RES(H_FLAG,reg.f);
-    RES(C_FLAG,reg.f);
+    reg.a |= aluOperand<op>();
+    setResultFlags(reg.a, 0);
 
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::XOR() {
-    uint8_t value;
-    switch (memory->read(reg.pc))
-    {
-        case 0xAF:
-            value = reg.a;
-            break;
-        case 0xA8:
-            value = reg.b;
-            break;
-        case 0xA9:
-            value = reg.c;
-            break;
-        case 0xAA:
-            value = reg.d;
-            break;
-        case 0xAB:
-            value = reg.e;
-            break;
-        case 0xAC:
-            value = reg.h;
-            break;
-        case 0xAD:
-            value = reg.l;
-            break;
-        case 0xAE:
-            value = memory->read(reg.hl);
-            break;
-        case 0xEE:
-            value = memory->read(reg.pc + 1);
-            reg.pc += 1;
-            break;
-    }
-
-    reg.a ^= value;
-
-    if (reg.a == 0)
-        SET(Z_FLAG,reg.f);
-    else
-        RES(Z_FLAG,reg.f);
-
-    RES(N_FLAG,reg.f);
-    RES(H_FLAG,reg.f);
-    RES(C_FLAG,reg.f);
+    reg.a ^= aluOperand<op>();
+    setResultFlags(reg.a, 0);
 
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::AND() {
-    uint8_t value;
-    switch(memory->read(reg.pc))
-    {
-        case 0xA7:
-            value = reg.a;
-            break;
-        case 0xA0:
-            value = reg.b;
-            break;
-        case 0xA1:
-            value = reg.c;
-            break;
-        case 0xA2:
-            value = reg.d;
-            break;
-        case 0xA3:
-            value = reg.e;
-            break;
-        case 0xA4:
-            value = reg.h;
-            break;
-        case 0xA5:
-            value = reg.l;
-            break;
-        case 0xA6:
-            value = memory->read(reg.hl);
-            break;
-        case 0xE6:
-            value = memory->read(reg.pc+1);
-            reg.pc++;
-            break;
-    }
-
-    reg.a &= value;
-
-    if (reg.a == 0)
-        SET(Z_FLAG,reg.f);
-    else
-        RES(Z_FLAG,reg.f);
-
-    RES(N_FLAG,reg.f);
-    SET(H_FLAG,reg.f);
-    RES(C_FLAG,reg.f);
+    reg.a &= aluOperand<op>();
+    setResultFlags(reg.a, 1 << H_FLAG);
 
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::CP() {
-    uint8_t value;
-    uint8_t newA = reg.a;
-    bool msb = testBit(7,reg.a);
-    switch(memory->read(reg.pc))
-    {
-        case 0xBF:
-            value = reg.a;
-            break;
-        case 0xB8:
-            value = reg.b;
-            break;
-        case 0xB9:
-            value = reg.c;
-            break;
-        case 0xBA:
-            value = reg.d;
-            break;
-        case 0xBB:
-            value = reg.e;
-            break;
-        case 0xBC:
-            value = reg.h;
-            break;
-        case 0xBD:
-            value = reg.l;
-            break;
-        case 0xBE:
-            value = memory->read(reg.hl);
-            break;
-        case 0xFE:
-            value = memory->read(reg.pc + 1);
-            reg.pc += 1;
-            break;
-    }
-
-    if (((newA & 0xf) - (value & 0xf)) < 0)
-        SET(H_FLAG,reg.f); //Set H flag
-    else
-        RES(H_FLAG,reg.f); //Clear H flag
-
-    newA -= value;
-
-    if (value > reg.a)
-        SET(C_FLAG,reg.f); //Set C flag
-    else
-        RES(C_FLAG,reg.f); //Clear C flag
-
-
-    SET(N_FLAG,reg.f); //Set N flag
-
-    if (newA == 0)
-        SET(Z_FLAG,reg.f); //Set Z flag
-    else
-        RES(Z_FLAG,reg.f); //Clear Z Flag
+    uint8_t value = aluOperand<op>();
+    setArithmeticFlags(FLAGS_SUB, reg.a, value, 0, reg.a - value);
 
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::ADD() {
-    uint8_t value;
-    bool carry = testBit(C_FLAG,reg.f);
-    bool adc = false;
-    bool msb = testBit(7,reg.a);
-
-    switch(memory->read(reg.pc))
-    {
-        case 0x87:
-            value = reg.a;
-            break;
-        case 0x80:
-            value = reg.b;
-            break;
-        case 0x81:
-            value = reg.c;
-            break;
-        case 0x82:
-            value = reg.d;
-            break;
-        case 0x83:
-            value = reg.e;
-            break;
-        case 0x84:
-            value = reg.h;
-            break;
-        case 0x85:
-            value = reg.l;
-            break;
-        case 0x86:
-            value = memory->read(reg.hl);
-            break;
-        case 0xC6:
-            value = memory->read(reg.pc + 1);
-            reg.pc++;
-            break;
-
-            //ADC Cases
-        case 0x8F:
-            value = reg.a;
-            adc = true;
-            break;
-        case 0x88:
-            value = reg.b;
-            adc = true;
-            break;
-        case 0x89:
-            value = reg.c;
-            adc = true;
-            break;
-        case 0x8A:
-            value = reg.d;
-            adc = true;
-            break;
-        case 0x8B:
-            value = reg.e;
-            adc = true;
-            break;
-        case 0x8C:
-            value = reg.h;
-            adc = true;
-            break;
-        case 0x8D:
-            value = reg.l;
-            adc = true;
-            break;
-        case 0x8E:
-            value = memory->read(reg.hl);
-            adc = true;
-            break;
-        case 0xCE:
-            value = memory->read(reg.pc + 1);
-            adc = true;
-            reg.pc++;
-            break;
-
-
-    }
-
-    if(value + reg.a > 0xff)
-        SET(C_FLAG,reg.f); //Set C flag
-    else
-        RES(C_FLAG,reg.f);
-
-    if(((reg.a & 0xf) + (value & 0xf)) & 0x10)
-        SET(H_FLAG,reg.f); //Set H flag
-    else
-        RES(H_FLAG,reg.f);
-
-    reg.a += value;
-
-    if(adc)
-    {
-        if (((reg.a & 0xf) + (carry & 0xf)) & 0x10)
-            SET(H_FLAG,reg.f); //Set H flag
-        if (carry + reg.a > 0xff)
-            SET(C_FLAG,reg.f); //Set C flag
-        reg.a += carry;
-    }
-
-    if(reg.a == 0)
-        SET(Z_FLAG,reg.f); //Set Z flag
-    else
-        RES(Z_FLAG,reg.f);
+    constexpr bool adc = op & 0x08; //ADC A,n
+    uint8_t carry = 0;
+    if constexpr (adc)
+        carry = carryFlag();
+    uint8_t value = aluOperand<op>();
 
-    RES(N_FLAG,reg.f); //Reset N flag
+    uint8_t a = reg.a;
+    reg.a += value + carry;
+    setArithmeticFlags(FLAGS_ADD, a, value, carry, reg.a);
 
     reg.pc += 1;
-
 }
 
+template<uint8_t op>
 void GB_CPU::ADD16() {
-    uint16_t * source = nullptr;
-
-    switch(memory->read(reg.pc))
-    {
-        case 0x09:
-            source = &reg.bc;
-            break;
-        case 0x19:
-            source = &reg.de;
-            break;
-        case 0x29:
-            source = &reg.hl;
-            break;
-        case 0x39:
-            source = &reg.sp;
-            break;
-    }
+    flags();
+    uint16_t source = r16<(op >> 4) & 0x3>();
 
     RES(N_FLAG,reg.f); //Reset N flag
 
-    if(reg.hl + *source > 0xffff)
+    if(reg.hl + source > 0xffff)
         SET(C_FLAG,reg.f); //Set C flag
     else
         RES(C_FLAG,reg.f);
 
-    if(((reg.hl & 0x0fff) + (*source & 0x0fff)) & 0x1000)
+    if(((reg.hl & 0x0fff) + (source & 0x0fff)) & 0x1000)
         SET(H_FLAG,reg.f);
     else
         RES(H_FLAG,reg.f);
 
-    reg.hl += *source;
+    reg.hl += source;
 
     reg.pc++;
 }
 
+template<uint8_t op>
 void GB_CPU::SUB() {
-    uint8_t value;
-    bool carry = testBit(C_FLAG,reg.f);
-    bool sbc = false;
-    switch (memory->read(reg.pc))
-    {
-        case 0x97:
-            value = reg.a;
-            break;
-        case 0x90:
-            value = reg.b;
-            break;
-        case 0x91:
-            value = reg.c;
-            break;
-        case 0x92:
-            value = reg.d;
-            break;
-        case 0x93:
-            value = reg.e;
-            break;
-        case 0x94:
-            value = reg.h;
-            break;
-        case 0x95:
-            value = reg.l;
-            break;
-        case 0x96:
-            value = memory->read(reg.hl);
-            break;
-        case 0xd6:
-            value = memory->read(reg.pc + 1);
-            reg.pc += 1;
-            break;
+    constexpr bool sbc = op & 0x08; //SBC A,n
+    uint8_t carry = 0;
+    if constexpr (sbc)
+        carry = carryFlag();
+    uint8_t value = aluOperand<op>();
 
-            //SBC Cases
-        case 0x9f:
-            value = reg.a;
-            sbc = true;
-            break;
-        case 0x98:
-            value = reg.b;
-            sbc = true;
-            break;
-        case 0x99:
-            value = reg.c;
-            sbc = true;
-            break;
-        case 0x9A:
-            value = reg.d;
-            sbc = true;
-            break;
-        case 0x9B:
-            value = reg.e;
-            sbc = true;
-            break;
-        case 0x9C:
-            value = reg.h;
-            sbc = true;
-            break;
-        case 0x9D:
-            value = reg.l;
-            sbc = true;
-            break;
-        case 0x9E:
-            value = memory->read(reg.hl);
-            sbc = true;
-            break;
-        case 0xDE:
-            value = memory->read(reg.pc + 1);
-            sbc = true;
-            reg.pc++;
-            break;
-    }
-
-    if (((reg.a & 0xf) - (value & 0xf)) < 0)
-        SET(H_FLAG,reg.f); //Set H flag
-    else
-        RES(H_FLAG,reg.f); //Clear H flag
-
-    if (value > reg.a)
-        SET(C_FLAG,reg.f); //Set C flag
-    else
-        RES(C_FLAG,reg.f); //Clear C flag
-
-    reg.a -= value;
-
-    if(sbc)
-    {
-        if (((reg.a & 0xf) - (carry & 0xf)) < 0)
-            SET(H_FLAG,reg.f); //Set H flag
-        if (carry > reg.a)
-            SET(C_FLAG,reg.f); //Set C flag
-        reg.a -= carry;
-    }
-
-
-    SET(N_FLAG,reg.f); //Set N flag
-
-    if (reg.a == 0)
-        SET(Z_FLAG,reg.f); //Set Z flag
-    else
-        RES(Z_FLAG,reg.f); //Clear Z Flag
+    uint8_t a = reg.a;
+    reg.a -= value + carry;
+    setArithmeticFlags(FLAGS_SUB, a, value, carry, reg.a);
 
     reg.pc += 1;
 }
 
+template<uint8_t op>
 void GB_CPU::LDNnn() {
-    uint16_t* destination = nullptr;
-    switch(memory->read(reg.pc))
-    {
-        case 0x01:
-            destination = &reg.bc;
-            break;
-        case 0x11:
-            destination = &reg.de;
-            break;
-        case 0x21:
-            destination = &reg.hl;
-            break;
-        case 0x31:
-            destination = &reg.sp;
-            break;
-    }
-
-    *destination = getWordFromMemory(reg.pc + 1);
+    r16<(op >> 4) & 0x3>() = getWordFromMemory(reg.pc + 1);
     reg.pc += 3;
 }
 
+template<uint8_t op>
 void GB_CPU::cpl() {
+    flags();
     reg.a = ~(reg.a);
     SET(N_FLAG,reg.f);
     SET(H_FLAG,reg.f);
     reg.pc++;
 }
 
+template<uint8_t op>
 void GB_CPU::di() {
     reg.pc++;
     reg.ime = 0;
 }
 
+template<uint8_t op>
 void GB_CPU::ei() {
     reg.pc++;
     cycles = 4 + execute();
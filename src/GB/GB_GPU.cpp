@@ -1,390 +1,365 @@
 #include "GB_GPU.h"
 
-GB_GPU::GB_GPU() {
-    //Initialize SDL
-    if( SDL_Init( SDL_INIT_VIDEO ) < 0 )
-    {
-        printf( "SDL could not initialize! SDL_Error: %s\n", SDL_GetError() );
-    }
-    else
-    {
-        //Create window
-        window = SDL_CreateWindow( "Gameboy Emulator", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 160*scale, 144*scale, SDL_WINDOW_SHOWN );
-        if( window == nullptr )
-        {
-            printf( "Window could not be created! SDL_Error: %s\n", SDL_GetError() );
-        }
-        else
-        {
-            //Get window surface
-            screenSurface = SDL_GetWindowSurface( window );
-
-            //Fill the surface white
-            SDL_FillRect( screenSurface, NULL, SDL_MapRGB( screenSurface->format, 0x0, 0x0, 0x0 ) );
-
-            //Update the surface
-            SDL_UpdateWindowSurface( window );
-        }
-
-        gameSurface = SDL_CreateRGBSurface(0, 160, 144, 32, 0, 0, 0, 0);
-        if (gameSurface == NULL)
-        {
-            SDL_Log("SDL_CreateRGBSurface() failed: %s", SDL_GetError());
-            exit(1);
-        }
-        pixels = (uint8_t*)gameSurface -> pixels;
-    }
-
+GB_GPU::GB_GPU(GB_MEM& memory) : memory(memory) {
 }
 
-void GB_GPU::update(short cycles) {
-    if((memory->read(LCDC) & 0b10000000) != 0b10000000) //Lcd enabled
+void GB_GPU::update(int cycles) {
+    if((memory.read(LCDC) & 0b10000000) != 0b10000000) //Lcd enabled
     {
         currentCycle = 0;
-        memory->write(LY,0);
-        memory->write(STAT, memory->read(STAT) | 0b00000001);
-        memory->write(STAT, memory->read(STAT) & 0b11111101);
+        memory.write(LY,0);
+        memory.write(STAT, memory.read(STAT) | 0b00000001);
+        memory.write(STAT, memory.read(STAT) & 0b11111101);
         return;
     }
 
     currentCycle += cycles;
     if(currentCycle < MODE_2_CYCLES && !vblank)  //LCD is accessing OAM - Mode 2
     {
-        if((memory->read(STAT) & (1 << 5)) && !oam) //If OAM interrupt is enabled and not requested already
+        if((memory.read(STAT) & (1 << 5)) && !oam) //If OAM interrupt is enabled and not requested already
         {
-            memory->write(0xFF0F, memory->read(0xFF0F) | (1 << 1));
+            memory.write(0xFF0F, memory.read(0xFF0F) | (1 << 1));
             oam = true;
         }
-        memory->write(STAT, memory->read(STAT) | 0b00000010);
-        memory->write(STAT, memory->read(STAT) & 0b11111110);
+        memory.write(STAT, memory.read(STAT) | 0b00000010);
+        memory.write(STAT, memory.read(STAT) & 0b11111110);
     }
     else if(currentCycle < MODE_3_CYCLES && !vblank) //LCD is accessing VRAM - Mode 3
     {
-        memory->write(STAT, memory->read(STAT) | 0b00000011);
+        memory.write(STAT, memory.read(STAT) | 0b00000011);
     }
     else if(currentCycle <= CYCLES_PER_LINE && !vblank)//HBlank period - Mode 0
     {
-        if((memory->read(STAT) & (1 << 3)) && !hblank) //If HBlank interrupt is enabled and not requested already
+        if((memory.read(STAT) & (1 << 3)) && !hblank) //If HBlank interrupt is enabled and not requested already
         {
-            memory->write(0xFF0F, memory->read(0xFF0F) | (1 << 1));
+            memory.write(0xFF0F, memory.read(0xFF0F) | (1 << 1));
             hblank = true;
         }
-        memory->write(STAT, memory->read(STAT) & 0b11111100);
+        memory.write(STAT, memory.read(STAT) & 0b11111100);
     }
     else //Advance line
     {
-        memory->write(LY, memory->read(LY) + 1);
-        uint16_t line = memory->read(LY);
+        memory.write(LY, memory.read(LY) + 1);
+        uint16_t line = memory.read(LY);
         currentCycle -= CYCLES_PER_LINE;
-        if (line <= 144) //Draw line on screen
+        if (line <= 144 && !skipRendering && !skipFrame) //Draw line on screen
         {
-            drawTiles(line);
-            drawSprites(line);
+            drawLine(line);
             //SDL_UpdateWindowSurface( window );
             //std::this_thread::sleep_for(std::chrono::duration<double>(0.01)); //Pause after drawing scanline
         }
 
         if(line > 153) //Return to top of screen
         {
-            memory->write(LY, 0);
-            drawTiles(0);
-            drawSprites(0);
+            memory.write(LY, 0);
+            skipFrame = framesSkipped < frameSkip;
+            framesSkipped = skipFrame ? framesSkipped + 1 : 0;
+            if(!skipRendering && !skipFrame)
+                drawLine(0);
             vblank = false;
         }
         else if(line == 144) //Start of vBlank - Trigger interrupt - Draw frame
         {
-            memory->write(0xFF0F, memory->read(0xFF0F) | 1);
-            drawArrayToSurface();
-            SDL_BlitScaled(gameSurface, NULL, screenSurface, NULL);
-            SDL_UpdateWindowSurface( window );
+            memory.write(0xFF0F, memory.read(0xFF0F) | 1);
+            if(frameHandler && !skipRendering && !skipFrame)
+                frameHandler();
         }
         else if(line == 153)
         {
             currentCycle = CYCLES_PER_LINE - 3;
         }
 
-        if(memory->read(LY) == memory->read(LYC))
+        if(memory.read(LY) == memory.read(LYC))
         {
-            memory->write(STAT, memory->read(STAT) | ( 1 << 2)); //Set Coincidence flag
-            if(memory->read(STAT) & (1 << 6)) //If LYC interrupt is enabled
-                memory->write(0xFF0F, memory->read(0xFF0F) | (1 << 1));
+            memory.write(STAT, memory.read(STAT) | ( 1 << 2)); //Set Coincidence flag
+            if(memory.read(STAT) & (1 << 6)) //If LYC interrupt is enabled
+                memory.write(0xFF0F, memory.read(0xFF0F) | (1 << 1));
         }
         else
-            memory->write(STAT, memory->read(STAT) & 0b11111011); //Reset Coincidence flag
+            memory.write(STAT, memory.read(STAT) & 0b11111011); //Reset Coincidence flag
 
         //Reset interrupt flags
         oam = false;
         hblank = false;
     }
 
-    if(memory->read(LY) >= 144)//vBlank period - Mode 1
+    if(memory.read(LY) >= 144)//vBlank period - Mode 1
     {
-        if((memory->read(STAT) & (1 << 5)) && !vblank) //If VBlank interrupt is enabled and not requested already
+        if((memory.read(STAT) & (1 << 5)) && !vblank) //If VBlank interrupt is enabled and not requested already
         {
-            memory->write(0xFF0F, memory->read(0xFF0F) | (1 << 1));
+            memory.write(0xFF0F, memory.read(0xFF0F) | (1 << 1));
             vblank = true;
         }
-        memory->write(STAT, memory->read(STAT) | 0b00000001);
-        memory->write(STAT, memory->read(STAT) & 0b11111101);
+        memory.write(STAT, memory.read(STAT) | 0b00000001);
+        memory.write(STAT, memory.read(STAT) & 0b11111101);
     }
 }
 
-void GB_GPU::drawTiles(uint16_t line) {
-    uint16_t displayAddress = 0;
-    uint16_t dataStart = 0;
-    bool usingWindow = false;
-    bool unsign = true;
+int GB_GPU::cyclesUntilNextEvent() {
+    uint8_t stat = memory.read(STAT);
+    if((memory.read(LCDC) & 0b10000000) != 0b10000000) //Nothing happens until the lcd is enabled again
+    {
+        if(currentCycle == 0 && memory.read(LY) == 0 && (stat & 0b11) == 0b01)
+            return CYCLES_PER_FRAME;
+        return 0;
+    }
 
-    //Background area and window location
-    uint8_t scrollY = memory->read(SCY);
-    uint8_t scrollX = memory->read(SCX);
-    uint8_t windowY = memory->read(WY);
-    uint8_t windowX = memory->read(WX) - 7;
+    if(vblank) //Every update advances a line while vBlank is latched
+        return 0;
 
-    //Check if window is enabled
-    if(memory->read(LCDC) & (1 << 5))
+    //Mode the current period leaves in STAT and the cycle at which it ends
+    uint8_t mode;
+    unsigned int end;
+    if(currentCycle < MODE_2_CYCLES)
     {
-        //Check if current line is within window range
-        if(windowY <= line)
-        {
-            usingWindow = true;
-        }
+        if((stat & (1 << 5)) && !oam) //OAM interrupt pending
+            return 0;
+        mode = 0b10;
+        end = MODE_2_CYCLES;
     }
-
-    switch(memory->read(LCDC) & (1 << (usingWindow ? 6 : 3))) //Get tile display range
+    else if(currentCycle < MODE_3_CYCLES)
     {
-        case 0: //9800-9BFF
-            displayAddress = 0x9800;
-            break;
-        case (1 << 3): //9C00-9FFF
-        case (1 << 6):
-            displayAddress = 0x9C00;
-            break;
+        mode = 0b11;
+        end = MODE_3_CYCLES;
     }
-    switch(memory->read(LCDC) & (1 << 4)) //Get tile data range
+    else if(currentCycle <= CYCLES_PER_LINE)
     {
-        case 0: //8800-97FF
-            unsign = false;
-            dataStart = 0x8800;
-            break;
-        case (1<< 4): //8000-8FFF
-            dataStart = 0x8000;
-            break;
+        if((stat & (1 << 3)) && !hblank) //HBlank interrupt pending
+            return 0;
+        mode = 0b00;
+        end = CYCLES_PER_LINE + 1;
     }
-
-    //Total tile area: 32x32 tiles (tile = 8x8 pixels)
-    //Screen area: 20x18 tiles
-    uint8_t yPos = 0;
-    if(!usingWindow)
-        yPos = scrollY + line;
     else
-        yPos = line - windowY;
+        return 0;
+
+    if(memory.read(LY) >= 144)
+    {
+        if(stat & (1 << 5)) //VBlank interrupt pending
+            return 0;
+        mode = 0b01;
+    }
+
+    if((stat & 0b11) != mode) //STAT not updated for this period yet
+        return 0;
 
-    //Which vertical tile is being used
-    uint16_t tileRow = (((uint8_t)(yPos/8))*32);
+    return end - currentCycle;
+}
 
-    for(int i = 0; i < 160; i++)
+void GB_GPU::drawLine(uint16_t line) {
+    drawTiles(line);
+    drawSprites(line);
+    if(line > 143)
+        return;
+
+    hashLine(line);
+    if(output == nullptr)
+        return;
+
+    memcpy(output + line*outputPitch, screen[line], sizeof(screen[line]));
+    if(line == outputLines)
+        outputLines++;
+    else
+        outputLines = line == 0 ? 1 : -1;
+}
+
+void GB_GPU::hashLine(int line) {
+    uint64_t hash = GB_STATE::checksum(screen[line][0], sizeof(screen[line]));
+    if(hash != lineHashes[line])
     {
-        uint8_t xPos = i + scrollX;
+        lineHashes[line] = hash;
+        dirtyLines[line] = true;
+        screenChanged = true;
+    }
+}
 
-        //Put x in window space if using window
-        if(usingWindow && (i >= windowX))
-            xPos = i - windowX;
+void GB_GPU::clearDirtyLines() {
+    std::fill(std::begin(dirtyLines), std::end(dirtyLines), false);
+    screenChanged = false;
+}
 
-        //Which horizontal tile is being used
-        uint16_t tileCol = (xPos/8);
-        short tileNum;
+uint64_t GB_GPU::frameHash() {
+    return GB_STATE::checksum((const uint8_t*)lineHashes, sizeof(lineHashes));
+}
 
-        //Get tile ID number
-        uint16_t tileAddress = displayAddress + tileRow + tileCol;
-        if(unsign)
-            tileNum = (uint8_t)memory->read(tileAddress);
-        else
-            tileNum = (char)memory->read(tileAddress);
+void GB_GPU::setOutput(uint8_t* pixels, int pitch) {
+    output = pixels;
+    outputPitch = pitch;
+    outputLines = 0;
+}
 
-        //Get memory location of tile ID
-        uint16_t tileLocation = dataStart;
+void GB_GPU::drawTiles(uint16_t line) {
+    if(line > 143)
+        return;
 
-        if(unsign)
-            tileLocation += (tileNum * 16);
-        else
-            tileLocation += ((tileNum + 128) * 16);
+    uint8_t lcdc = memory.read(LCDC);
 
-        //Get the correct line of the tile to draw
-        uint8_t column = yPos % 8;
-        column *= 2; //Each line is two bytes
-        uint8_t data1 = memory->read(tileLocation + column);
-        uint8_t data2 = memory->read(tileLocation + column + 1);
+    //Background area and window location
+    uint8_t scrollY = memory.read(SCY);
+    uint8_t scrollX = memory.read(SCX);
+    uint8_t windowY = memory.read(WY);
+    uint8_t windowX = memory.read(WX) - 7;
 
-        int colorBit = xPos % 8;
-        colorBit -= 7;
-        colorBit *= -1;
+    //Check if window is enabled and the current line is within its range
+    bool usingWindow = (lcdc & (1 << 5)) && windowY <= line;
 
-        //Combine the bits to get the color number of the pixel
-        int colorNum = (data2 & (1 << colorBit)) >> (colorBit);
-        colorNum <<= 1;
-        colorNum |= (data1 & (1 << colorBit)) >> colorBit;
+    //Tile display range, 9800-9BFF or 9C00-9FFF
+    uint16_t displayAddress = (lcdc & (1 << (usingWindow ? 6 : 3))) ? 0x9C00 : 0x9800;
 
-        uint8_t col = getColor(colorNum, 0xFF47);
-        if (xPos % 8 == 7 && (col == 0)) {}
-        //col += 2;
+    //Tile data range, 8000-8FFF with unsigned tile numbers or 8800-97FF with signed ones
+    bool unsign = lcdc & (1 << 4);
 
-        uint8_t red = 0;
-        uint8_t blue = 0;
-        uint8_t green = 0;
+    //Total tile area: 32x32 tiles (tile = 8x8 pixels)
+    //Screen area: 20x18 tiles
+    uint8_t yPos = usingWindow ? line - windowY : scrollY + line;
+    const uint8_t* tileMap = &memory.memory[displayAddress + ((uint8_t)(yPos/8))*32];
+    uint8_t row = yPos % 8;
+
+    //Pixels left of the window still use its map and line, with the background scroll
+    int windowStart = usingWindow ? std::min<int>(windowX, 160) : 160;
+
+    //Color numbers of the line, copied a whole tile row at a time
+    //A row cut by the scroll starts before pixel 0, one cut by the window edge is overwritten by the window
+    uint8_t colors[8 + 160 + 8];
+    int i = 0;
+    while(i < 160)
+    {
+        uint8_t xPos = i < windowStart ? i + scrollX : i - windowX;
+        int end = i < windowStart ? windowStart : 160;
 
-        switch(col)
-        {
-            case 0x00: //White
-                red = 255;
-                green = 255;
-                blue = 255;
-                break;
-            case 0x01: //Light Gray
-                red = 0xCC;
-                green = 0xCC;
-                blue = 0xCC;
-                break;
-            case 0x02: //Dark Gray
-                red = 0x77;
-                green = 0x77;
-                blue = 0x77;
-                break;
-        }
+        uint8_t tileNum = tileMap[xPos/8];
+        int tile = unsign ? tileNum : 256 + (int8_t)tileNum;
+        memcpy(colors + 8 + i - xPos % 8, tileRow(tile, row), 8);
+        i += std::min(8 - (xPos % 8), end - i);
+    }
 
-        //Check that the pixel is in bounds
-        if((line < 0) || (line > 143) || (i < 0) || (i > 159))
-            continue;
+    if(memory.paletteDirty)
+        updatePalettes();
+    GB_PIXELS::mapColors(colors + 8, 160, palettes[0], screen[line][0]);
+}
 
-        screen[line][i][0] = blue;
-        screen[line][i][1] = green;
-        screen[line][i][2] = red;
-        screen[line][i][3] = colorNum;
+const uint8_t* GB_GPU::tileRow(int tile, int row) {
+    if(memory.tileDirty[tile])
+    {
+        GB_PIXELS::decodeTile(&memory.memory[TILE_DATA_BEGIN + tile*16], tiles[tile][0]);
+        memory.tileDirty[tile] = false;
     }
+    return tiles[tile][row];
 }
 
 void GB_GPU::drawSprites(uint16_t line) {
-    bool tallSprites = false;
-    if((memory->read(LCDC) & 0x4) == 0x4)
-        tallSprites = true;
+    if(line > 143)
+        return;
 
-    std::vector<sprite> sprites;
+    int ySize = (memory.read(LCDC) & 0x4) == 0x4 ? 16 : 8;
+    if(memory.paletteDirty)
+        updatePalettes();
 
-    for(int i = 0; i < 40; i++)
+    //OAM scan: the first 10 sprites in OAM order that cover this line, whether on screen horizontally or not
+    uint8_t selected[SPRITES_PER_LINE];
+    int count = 0;
+    for(int i = 0; i < SPRITE_COUNT && count < SPRITES_PER_LINE; i++)
     {
-        int index = i*4;
-
-        sprite s;
-
-        s.yPos = memory->read(0xFE00+index) - 16;
-        s.xPos = memory->read(0xFE00+index+1) - 8;
-        s.tileLocation = memory->read(0xFE00+index+2);
-        s.attributes = memory->read(0xFE00+index+3);
+        const sprite& s = memory.sprites[i];
+        if(line >= s.yPos && line < s.yPos + ySize)
+            selected[count++] = i;
+    }
 
-        sprites.push_back(s);
+    //Highest priority first: smaller x, then earlier in OAM
+    for(int i = 1; i < count; i++)
+    {
+        uint8_t current = selected[i];
+        int j = i;
+        for(; j > 0 && memory.sprites[selected[j - 1]].xPos > memory.sprites[current].xPos; j--)
+            selected[j] = selected[j - 1];
+        selected[j] = current;
     }
 
-    std::sort(sprites.begin(), sprites.end(), spriteSort);
+    //Set once a sprite has an opaque pixel in a column, lower priority sprites don't show there even when the background does
+    bool taken[160] = {};
 
-    for(auto s : sprites)
+    for(int i = 0; i < count; i++)
     {
-        uint8_t yPos = s.yPos;
-        uint8_t xPos = s.xPos;
-        uint8_t tileLocation = s.tileLocation;
+        const sprite& s = memory.sprites[selected[i]];
         uint8_t attributes = s.attributes;
 
         bool bgPriority = (attributes & (1 << 7)) >> 7;
         bool yFlip = ((attributes & 0x40) == 0x40);
         bool xFlip = ((attributes & 0x20) == 0x20);
 
-        uint8_t ySize = 8;
-        if(tallSprites)
+        int spriteLine = line - s.yPos;
+
+        if(yFlip)
         {
-            ySize = 16;
+            spriteLine -= ySize;
+            spriteLine *= -1;
         }
-        //If current sprite connects with current scanline
-        if(line >= yPos && line < (yPos+ySize))
+
+        //Tall sprites, and flipped lines one past the end, run on into the following tiles
+        int dataRow = s.tileLocation*8 + spriteLine;
+        const uint8_t* tileColors = tileRow(dataRow / 8, dataRow % 8);
+
+        uint8_t colors[8];
+        for(int tilePixel = 0; tilePixel < 8; tilePixel++)
+            colors[tilePixel] = tileColors[xFlip ? 7 - tilePixel : tilePixel];
+
+        //Only blue, green and red are copied, the fourth byte stays the background's
+        uint8_t pixels[8][4];
+        GB_PIXELS::mapColors(colors, 8, palettes[(attributes & (1 << 4)) ? 2 : 1], pixels[0]);
+
+        for(int tilePixel = 0; tilePixel < 8; tilePixel++)
+        {
+            int pixel = s.xPos + tilePixel;
+
+            //Check that the pixel is in bounds
+            if((pixel < 0) || (pixel > 159))
+                continue;
+
+            //White is transparent for sprites
+            if(colors[tilePixel] == 0 || taken[pixel])
+                continue;
+            taken[pixel] = true;
+
+            //Check if background should display over sprite
+            if(bgPriority == 1 && screen[line][pixel][3] != 0)
+                continue;
+
+            memcpy(screen[line][pixel], pixels[tilePixel], 3);
+        }
+    }
+}
+
+uint32_t GB_GPU::packPixel(uint32_t color, uint8_t colorNum) {
+    uint8_t bytes[4] = {(uint8_t)color, (uint8_t)(color >> 8), (uint8_t)(color >> 16), colorNum};
+    uint32_t packed;
+    memcpy(&packed, bytes, 4);
+    return packed;
+}
+
+void GB_GPU::updatePalettes() {
+    for(int palette = 0; palette < 3; palette++)
+    {
+        for(int colorNum = 0; colorNum < 4; colorNum++)
         {
-            int spriteLine = line - yPos;
-
-            if(yFlip)
-            {
-                spriteLine -= ySize;
-                spriteLine *= -1;
-            }
-
-            spriteLine *= 2;
-            uint16_t dataAddress = (0x8000 + (tileLocation * 16)) + spriteLine;
-            uint8_t data1 = memory->read(dataAddress);
-            uint8_t data2 = memory->read(dataAddress+1);
-
-            for(int tilePixel = 7; tilePixel >= 0; tilePixel--)
-            {
-                int colorBit = tilePixel;
-
-                if(xFlip)
-                {
-                    colorBit -= 7;
-                    colorBit *= -1;
-                }
-
-                int colorNum = (data2 & (1 << colorBit)) >> colorBit;
-                colorNum <<= 1;
-                colorNum |= (data1 & (1 <<colorBit)) >> colorBit;
-
-                uint16_t colorAddress = (attributes & (1 << 4)) >> 4 ? 0xFF49 : 0xFF48;
-                uint8_t color = getColor(colorNum, colorAddress);
-
-                //White is transparent for sprites
-                if(colorNum == 0)
-                    continue;
-
-                int xPix = 0 - tilePixel;
-                xPix += 7;
-                int pixel = xPix + xPos;
-
-                //Check if background should display over sprite
-                if(bgPriority == 1 && screen[line][pixel][3] != 0)
-                    continue;
-
-                uint8_t red = 0;
-                uint8_t blue = 0;
-                uint8_t green = 0;
-
-                switch(color)
-                {
-                    case 0x00: //White
-                        red = 255;
-                        green = 255;
-                        blue = 255;
-                        break;
-                    case 0x01: //Light Gray
-                        red = 0xCC;
-                        green = 0xCC;
-                        blue = 0xCC;
-                        break;
-                    case 0x02: //Dark Gray
-                        red = 0x77;
-                        green = 0x77;
-                        blue = 0x77;
-                        break;
-                }
-
-                //Check that the pixel is in bounds
-                if((line < 0) || (line > 143) || (pixel < 0) || (pixel > 159))
-                    continue;
-
-                screen[line][pixel][0] = blue;
-                screen[line][pixel][1] = green;
-                screen[line][pixel][2] = red;
-            }
+            uint8_t shade = getColor(colorNum, 0xFF47 + palette);
+            palettes[palette][colorNum] = packPixel(theme[palette][shade], palette == 0 ? colorNum : 0);
         }
     }
+    memory.paletteDirty = false;
+}
+
+void GB_GPU::setTheme(const uint32_t colors[4]) {
+    for(int palette = 0; palette < 3; palette++)
+        setTheme(palette, colors);
+}
+
+void GB_GPU::setTheme(int palette, const uint32_t colors[4]) {
+    std::copy(colors, colors + 4, theme[palette]);
+    memory.paletteDirty = true;
 }
 
 uint8_t GB_GPU::getColor(int colorNum, uint16_t address) {
     uint8_t color = 0x00; //Default white
-    uint8_t palette = memory->read(address);
+    uint8_t palette = memory.read(address);
     uint8_t hi = 0;
     uint8_t lo = 0;
 
@@ -417,20 +392,18 @@ uint8_t GB_GPU::getColor(int colorNum, uint16_t address) {
     return color;
 }
 
-void GB_GPU::drawArrayToSurface() {
-    for(int i = 0; i < 144; i++)
+void GB_GPU::serialize(GB_STATE& state) {
+    state.field(currentCycle);
+    state.field(hblank);
+    state.field(oam);
+    state.field(vblank);
+    state.field(screen);
+
+    //Lines already in output belong to the old timeline
+    if(state.loading)
     {
-        for(int j = 0; j < 160; j++)
-        {
-            pixels[4 * (i * gameSurface -> w + j) + 0] = screen[i][j][0];
-            pixels[4 * (i * gameSurface -> w + j) + 1] = screen[i][j][1];
-            pixels[4 * (i * gameSurface -> w + j) + 2] = screen[i][j][2];
-        }
+        outputLines = -1;
+        for(int line = 0; line < 144; line++)
+            hashLine(line);
     }
 }
-
-bool GB_GPU::spriteSort(const sprite &lhs, const sprite &rhs) {
-    if (lhs.xPos == rhs.xPos)
-        return lhs.tileLocation > rhs.tileLocation;
-    return lhs.xPos > rhs.xPos;
-}
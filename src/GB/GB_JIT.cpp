@@ -0,0 +1,296 @@
+#ifdef GGBOY_JIT
+#include "GB_JIT.h"
+#include "GB_CPU.h"
+#include <sys/mman.h>
+
+#if !defined(__x86_64__) || defined(_WIN32)
+#error "GGBOY_JIT emits x86-64 System V code"
+#endif
+
+GB_JIT::GB_JIT(GB_CPU* cpu, GB_MEM& memory) : cpu(cpu), memory(memory) {
+    uint8_t* base = reinterpret_cast<uint8_t*>(cpu);
+    auto offset = [base](void* field) { return int32_t(reinterpret_cast<uint8_t*>(field) - base); };
+
+    //Same order as the operand bits of an opcode, 6 being (HL)
+    r8Offset[0] = offset(&cpu->reg.b);
+    r8Offset[1] = offset(&cpu->reg.c);
+    r8Offset[2] = offset(&cpu->reg.d);
+    r8Offset[3] = offset(&cpu->reg.e);
+    r8Offset[4] = offset(&cpu->reg.h);
+    r8Offset[5] = offset(&cpu->reg.l);
+    r8Offset[6] = 0;
+    r8Offset[7] = offset(&cpu->reg.a);
+    r16Offset[0] = offset(&cpu->reg.bc);
+    r16Offset[1] = offset(&cpu->reg.de);
+    r16Offset[2] = offset(&cpu->reg.hl);
+    r16Offset[3] = offset(&cpu->reg.sp);
+    pcOffset = offset(&cpu->reg.pc);
+    batchCyclesOffset = offset(&cpu->batchCycles);
+
+    void* mapping = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mapping == MAP_FAILED)
+        std::cout << "Could not allocate JIT code buffer, interpreting only" << std::endl;
+    else
+        code = static_cast<uint8_t*>(mapping);
+}
+
+GB_JIT::~GB_JIT() {
+    if(code != nullptr)
+        munmap(code, CODE_SIZE);
+}
+
+GB_JIT::block* GB_JIT::find(uint16_t pc) {
+    block* cached = cache[pc];
+    if(cached != nullptr && isValid(*cached, pc))
+        return cached;
+
+    if(code == nullptr || ++heat[pc] < HOT_THRESHOLD)
+        return nullptr;
+    heat[pc] = 0;
+
+    uint32_t key = (bankFor(pc) << 16) | pc;
+    auto existing = blocks.find(key);
+    if(existing != blocks.end() && isValid(existing->second, pc))
+        return cache[pc] = &existing->second;
+
+    block translated = translate(pc); //May flush every block
+    return cache[pc] = &blocks.insert_or_assign(key, translated).first->second;
+}
+
+uint8_t GB_JIT::bankFor(uint16_t pc) {
+    if(pc >= 0x4000 && pc <= 0x7FFF)
+        return memory.currentROMBank;
+    if(pc >= 0xA000 && pc <= 0xBFFF)
+        return memory.currentRAMBank;
+    return 0;
+}
+
+bool GB_JIT::isValid(const block& b, uint16_t pc) {
+    return b.bank == bankFor(pc) && (!b.inRAM || b.generation == memory.codeGeneration[b.page]);
+}
+
+GB_JIT::block GB_JIT::translate(uint16_t pc) {
+    block b;
+    b.bank = bankFor(pc);
+    b.page = pc >> 8;
+
+    //Blocks never cross a bank or, in RAM, a page they are invalidated by
+    int limit;
+    switch(pc)
+    {
+        case 0x0000 ... 0x3FFF:
+            limit = 0x4000;
+            break;
+        case 0x4000 ... 0x7FFF:
+            limit = 0x8000;
+            break;
+        case 0xA000 ... 0xDFFF: //External and work RAM
+            b.inRAM = true;
+            limit = (b.page + 1) << 8;
+            break;
+        case 0xFF80 ... 0xFFFE: //High RAM
+            b.inRAM = true;
+            limit = 0xFFFF;
+            break;
+        default: //VRAM, echo RAM, OAM and I/O are left to the interpreter
+            return b;
+    }
+    if(b.inRAM)
+        b.generation = memory.codeGeneration[b.page];
+
+    if(CODE_SIZE - codeUsed < MAX_BLOCK_BYTES)
+        flush();
+
+    uint8_t* start = code + codeUsed;
+    cursor = start;
+    emit8(0x53); //push rbx
+    emit8(0x48); emit8(0x89); emit8(0xFB); //mov rbx, rdi
+
+    uint16_t address = pc;
+    uint16_t storedPC = pc; //Value of reg.pc at this point of the generated code
+    int pendingCycles = 0; //Cycles of the instructions not yet added to batchCycles
+    int count = 0;
+    bool terminal = false;
+    while(count < MAX_BLOCK_INSTRUCTIONS && !terminal)
+    {
+        uint8_t op = memory.read(address);
+        uint8_t size = length(op);
+        if(address + size > limit)
+            break;
+
+        opClass type = classify(address, op);
+        if(type == FALLBACK)
+            break;
+
+        b.cyclesBeforeLast = b.cycles;
+        b.cycles += GB_CPU::opcodeCycles[op];
+
+        if(type == NATIVE)
+            emitNative(address, op);
+        else
+        {
+            //A handler reading DIV catches the timers up to batchCycles, so it has to be current
+            if(pendingCycles != 0)
+                emitAddCycles(pendingCycles);
+            pendingCycles = 0;
+            if(storedPC != address)
+                emitSetPC(address);
+            emitCall(op);
+            storedPC = address + size; //Handlers leave pc on the next instruction
+            terminal = type == TERMINAL;
+        }
+
+        pendingCycles += GB_CPU::opcodeCycles[op];
+        address += size;
+        count++;
+    }
+
+    if(count == 0)
+        return b;
+
+    if(pendingCycles != 0)
+        emitAddCycles(pendingCycles);
+    if(!terminal && storedPC != address)
+        emitSetPC(address);
+    emit8(0x5B); //pop rbx
+    emit8(0xC3); //ret
+
+    codeUsed = cursor - code;
+    b.instructions = count;
+    b.code = reinterpret_cast<void (*)(GB_CPU*)>(start);
+    if(b.inRAM)
+        memory.protectCode(pc);
+    return b;
+}
+
+GB_JIT::opClass GB_JIT::classify(uint16_t pc, uint8_t op) {
+    switch(op)
+    {
+        case 0x00: //NOP
+        case 0x01: case 0x11: case 0x21: case 0x31: //LD rr,nn
+        case 0x03: case 0x13: case 0x23: case 0x33: //INC rr
+        case 0x0B: case 0x1B: case 0x2B: case 0x3B: //DEC rr
+        case 0x06: case 0x0E: case 0x16: case 0x1E: case 0x26: case 0x2E: case 0x3E: //LD r,n
+        case 0xF9: //LD SP,HL
+            return NATIVE;
+        case 0x40 ... 0x7F: //LD r,r
+            if(op == 0x76 || ((op >> 3) & 7) == 6) //HALT and stores to (HL)
+                return FALLBACK;
+            return (op & 7) == 6 ? CALL : NATIVE;
+        case 0x80 ... 0xBF: //ALU A,r
+        case 0xC6: case 0xCE: case 0xD6: case 0xDE: case 0xE6: case 0xEE: case 0xF6: case 0xFE: //ALU A,n
+        case 0x04: case 0x0C: case 0x14: case 0x1C: case 0x24: case 0x2C: case 0x3C: //INC r
+        case 0x05: case 0x0D: case 0x15: case 0x1D: case 0x25: case 0x2D: case 0x3D: //DEC r
+        case 0x07: case 0x0F: case 0x17: case 0x1F: //RLCA, RRCA, RLA, RRA
+        case 0x27: case 0x2F: case 0x37: case 0x3F: //DAA, CPL, SCF, CCF
+        case 0x09: case 0x19: case 0x29: case 0x39: //ADD HL,rr
+        case 0x0A: case 0x1A: case 0x2A: case 0x3A: case 0xFA: //Loads into A from memory
+        case 0xC1: case 0xD1: case 0xE1: case 0xF1: //POP
+        case 0xE8: case 0xF8: //ADD SP,n and LD HL,SP+n
+            return CALL;
+        case 0xCB: //Prefixed ops on (HL) write back to memory
+            return (memory.read(pc + 1) & 7) == 6 ? FALLBACK : CALL;
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: //JR
+        case 0xC3: case 0xC2: case 0xCA: case 0xD2: case 0xDA: //JP
+        case 0xC9: case 0xC0: case 0xC8: case 0xD0: case 0xD8: //RET
+        case 0xE9: //JP (HL)
+            return TERMINAL;
+        default: //Stores, stack pushes, I/O and interrupt control
+            return FALLBACK;
+    }
+}
+
+uint8_t GB_JIT::length(uint8_t op) {
+    switch(op)
+    {
+        case 0x01: case 0x11: case 0x21: case 0x31:
+        case 0x08: case 0xEA: case 0xFA:
+        case 0xC2: case 0xC3: case 0xC4: case 0xCA: case 0xCC: case 0xCD:
+        case 0xD2: case 0xD4: case 0xDA: case 0xDC:
+            return 3;
+        case 0x06: case 0x0E: case 0x16: case 0x1E: case 0x26: case 0x2E: case 0x36: case 0x3E:
+        case 0x10: case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+        case 0xC6: case 0xCE: case 0xD6: case 0xDE: case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+        case 0xE0: case 0xF0: case 0xE8: case 0xF8: case 0xCB:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+void GB_JIT::flush() {
+    blocks.clear();
+    std::fill(std::begin(cache), std::end(cache), nullptr);
+    codeUsed = 0;
+}
+
+void GB_JIT::emit8(uint8_t value) {
+    *cursor++ = value;
+}
+
+void GB_JIT::emit16(uint16_t value) {
+    emit8(value & 0xFF);
+    emit8(value >> 8);
+}
+
+void GB_JIT::emit32(uint32_t value) {
+    emit16(value & 0xFFFF);
+    emit16(value >> 16);
+}
+
+void GB_JIT::emit64(uint64_t value) {
+    emit32(value & 0xFFFFFFFF);
+    emit32(value >> 32);
+}
+
+void GB_JIT::emitNative(uint16_t pc, uint8_t op) {
+    if(op == 0x00)
+        return;
+
+    if(op == 0xF9) //LD SP,HL
+    {
+        emit8(0x66); emit8(0x8B); emit8(0x83); emit32(r16Offset[2]); //mov ax, [rbx+hl]
+        emit8(0x66); emit8(0x89); emit8(0x83); emit32(r16Offset[3]); //mov [rbx+sp], ax
+        return;
+    }
+
+    switch(op & 0xCF)
+    {
+        case 0x01: //LD rr,nn
+            emit8(0x66); emit8(0xC7); emit8(0x83); emit32(r16Offset[(op >> 4) & 3]);
+            emit16(memory.read(pc + 1) | (memory.read(pc + 2) << 8));
+            return;
+        case 0x03: //INC rr
+            emit8(0x66); emit8(0xFF); emit8(0x83); emit32(r16Offset[(op >> 4) & 3]);
+            return;
+        case 0x0B: //DEC rr
+            emit8(0x66); emit8(0xFF); emit8(0x8B); emit32(r16Offset[(op >> 4) & 3]);
+            return;
+    }
+
+    if((op & 0xC7) == 0x06) //LD r,n
+    {
+        emit8(0xC6); emit8(0x83); emit32(r8Offset[(op >> 3) & 7]);
+        emit8(memory.read(pc + 1));
+        return;
+    }
+
+    //LD r,r
+    emit8(0x8A); emit8(0x83); emit32(r8Offset[op & 7]); //mov al, [rbx+src]
+    emit8(0x88); emit8(0x83); emit32(r8Offset[(op >> 3) & 7]); //mov [rbx+dst], al
+}
+
+void GB_JIT::emitCall(uint8_t op) {
+    emit8(0x48); emit8(0x89); emit8(0xDF); //mov rdi, rbx
+    emit8(0x48); emit8(0xB8); emit64(reinterpret_cast<uint64_t>(GB_CPU::handlerEntries[op])); //mov rax, handler
+    emit8(0xFF); emit8(0xD0); //call rax
+}
+
+void GB_JIT::emitAddCycles(int32_t cycles) {
+    emit8(0x81); emit8(0x83); emit32(batchCyclesOffset); emit32(cycles); //add dword [rbx+batchCycles], imm32
+}
+
+void GB_JIT::emitSetPC(uint16_t pc) {
+    emit8(0x66); emit8(0xC7); emit8(0x83); emit32(pcOffset); emit16(pc); //mov word [rbx+pc], imm16
+}
+#endif
@@ -0,0 +1,16 @@
+#include "GB_MAILBOX.h"
+
+GB_MAILBOX::frame& GB_MAILBOX::back() {
+    return frames[writing];
+}
+
+void GB_MAILBOX::publish() {
+    writing = middle.exchange(writing | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+const GB_MAILBOX::frame* GB_MAILBOX::take() {
+    if(!(middle.load(std::memory_order_relaxed) & FRESH))
+        return nullptr;
+    reading = middle.exchange(reading, std::memory_order_acq_rel) & ~FRESH;
+    return &frames[reading];
+}
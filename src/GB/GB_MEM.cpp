@@ -1,18 +1,35 @@
 #include "GB_MEM.h"
 
-void GB_MEM::loadRom(std::string &fileName) {
+bool GB_MEM::loadRom(std::string &fileName, bool loadSave) {
     std::ifstream rom(fileName, std::ios::in | std::ios::binary | std::ios::ate);
+    if(!rom)
+        return false;
     std::streamoff size = rom.tellg();
-    fullRom.resize(size);
+    std::vector<unsigned char> data(size);
     //std::cout << size;
 
     rom.seekg(std::ios::beg);
-    rom.read((char*)&fullRom[0], size * sizeof(unsigned char));
+    rom.read((char*)&data[0], size * sizeof(unsigned char));
     rom.close();
 
     //fullRom.push_back(0);
     //while (rom.read(reinterpret_cast<char *>(fullRom.front()) + memoryLocation, 1)) { memoryLocation++; fullRom.push_back(0);}
 
+    return loadRom(std::move(data), loadSave);
+}
+
+bool GB_MEM::loadRom(std::vector<unsigned char> rom, bool loadSave) {
+    //Smallest cartridge is two banks, and the boot rom refuses a cartridge whose header checksum doesn't match
+    if(rom.size() < 0x8000)
+        return false;
+    unsigned char checksum = 0;
+    for(int i = 0x134; i < 0x14D; i++)
+        checksum = checksum - rom[i] - 1;
+    if(checksum != rom[0x14D])
+        return false;
+
+    fullRom = std::move(rom);
+
     for (int i = 0; i < 0x4000; i++)
     {
         //std::cout << std::hex << static_cast<int>(fullRom[i]) << " ";
@@ -42,6 +59,8 @@ void GB_MEM::loadRom(std::string &fileName) {
         default:
             break;
     }
+    if(!loadSave)
+        saving = false;
 
     if(saving)
     {
@@ -74,9 +93,86 @@ void GB_MEM::loadRom(std::string &fileName) {
             ROMBanks = 96;
             break;
     }
+
+    markTilesDirty();
+    parseSprites();
+    paletteDirty = true;
+    updatePageTables();
+    return true;
+}
+
+void GB_MEM::updatePageTables() {
+    for(int page = 0; page < 0x100; page++)
+    {
+        unsigned char* readPage = nullptr;
+        unsigned char* writePage = nullptr;
+        switch(page)
+        {
+            case 0x00 ... 0x3F: //ROM Bank 0
+                readPage = &memory[page << 8];
+                break;
+            case 0x80 ... 0x97: //VRAM tile data, written through the slow path to mark tiles dirty
+                readPage = &memory[page << 8];
+                break;
+            case 0x98 ... 0x9F: //VRAM tile maps
+                readPage = writePage = &memory[page << 8];
+                break;
+            case 0xC0 ... 0xDF: //Work RAM
+                readPage = writePage = &memory[page << 8];
+                break;
+            case 0xE0 ... 0xFD: //Same as 0xC000 - 0xDDFF
+                readPage = writePage = &memory[(page - 0x20) << 8];
+                break;
+            default: //Banked regions are mapped below, OAM, I/O and High RAM always take the slow path
+                break;
+        }
+
+#ifdef GGBOY_JIT
+        if(codePages[page] || (page >= 0xE0 && page <= 0xFD && codePages[page - 0x20]))
+            writePage = nullptr;
+#endif
+
+        readPages[page] = readPage;
+        writePages[page] = writePage;
+    }
+
+    mapROMBank();
+    mapRAMBank();
+}
+
+void GB_MEM::mapROMBank() {
+    size_t bankStart = currentROMBank*0x4000;
+    for(int page = 0; page < 0x40; page++)
+    {
+        size_t offset = bankStart + (page << 8);
+        readPages[0x40 + page] = offset < fullRom.size() ? &fullRom[offset] : nullptr; //Banks past the end of the rom take the slow path
+    }
 }
 
-unsigned char GB_MEM::read(unsigned short index) {
+void GB_MEM::mapRAMBank() {
+    unsigned char* bank = &RAMBanks[currentRAMBank*0x2000];
+    for(int page = 0; page < 0x20; page++)
+    {
+        readPages[0xA0 + page] = &bank[page << 8];
+        writePages[0xA0 + page] = enableRam ? &bank[page << 8] : nullptr;
+#ifdef GGBOY_JIT
+        if(codePages[0xA0 + page])
+            writePages[0xA0 + page] = nullptr;
+#endif
+    }
+}
+
+#ifdef GGBOY_JIT
+void GB_MEM::protectCode(unsigned short index) {
+    if(!codePages[index >> 8])
+    {
+        codePages[index >> 8] = true;
+        updatePageTables();
+    }
+}
+#endif
+
+unsigned char GB_MEM::readSlow(unsigned short index) {
     // Uncomment if using gameboy-doctor
     // if (index == LY) {
     //     return 0x90;
@@ -127,7 +223,13 @@ unsigned char GB_MEM::read(unsigned short index) {
                     break;
             }
             return memory[index];
-        case 0xFF01 ... 0xFF4C: //IO Ports
+        case 0xFF01 ... 0xFF03: //Serial Port
+            return memory[index];
+        case 0xFF04: //Divider register - only brought up to date when read
+            if(syncHandler)
+                syncHandler();
+            return memory[index];
+        case 0xFF05 ... 0xFF4C: //IO Ports
             return memory[index];
         case 0xFF4D: // CGB KEY1 register - should always read 0xFF for DMG
             return 0xFF;
@@ -146,7 +248,7 @@ unsigned char GB_MEM::read(unsigned short index) {
     }
 }
 
-void GB_MEM::write(unsigned short index, unsigned char value) {
+void GB_MEM::writeSlow(unsigned short index, unsigned char value) {
     switch(index)
     {
         case 0x0000 ... 0x3FFF: //ROM Bank 0
@@ -155,7 +257,11 @@ void GB_MEM::write(unsigned short index, unsigned char value) {
         case 0x4000 ... 0x7FFF: //ROM Bank 1 to n
             handleBanking(index,value);
             break;
-        case 0x8000 ... 0x9FFF: //VRAM
+        case TILE_DATA_BEGIN ... TILE_DATA_END: //VRAM tile data
+            memory[index] = value;
+            tileDirty[(index - TILE_DATA_BEGIN) >> 4] = true;
+            break;
+        case 0x9800 ... 0x9FFF: //VRAM tile maps
             memory[index] = value;
             break;
         case 0xA000 ... 0xBFFF: //External RAM if any
@@ -163,19 +269,24 @@ void GB_MEM::write(unsigned short index, unsigned char value) {
             {
                 unsigned short newAddress = index - 0xA000;
                 RAMBanks[newAddress + (currentRAMBank*0x2000)] = value;
+                invalidateCode(index);
             }
             break;
         case 0xC000 ... 0xCFFF: //Work RAM Bank 0
             memory[index] = value;
+            invalidateCode(index);
             break;
         case 0xD000 ... 0xDFFF: //Work RAM Bank 1
             memory[index] = value;
+            invalidateCode(index);
             break;
         case 0xE000 ... 0xFDFF: //Same as 0xC000 - 0xDDFF
             memory[index - 0x2000] = value;
+            invalidateCode(index - 0x2000);
             break;
-        case 0xFE00 ... 0xFE9F: //Sprite Attribute Table (OAM)
+        case OAM_BEGIN ... OAM_END: //Sprite Attribute Table (OAM)
             memory[index] = value;
+            parseSprite(index);
             break;
         case 0xFEA0 ... 0xFEFF: //Not Usable
             return;
@@ -192,12 +303,22 @@ void GB_MEM::write(unsigned short index, unsigned char value) {
             memory[index] = value;
             break;
         case 0xFF04: //Divider register - Writing always makes timer 0
+            requestSync();
             memory[index] = 0;
             break;
-        case 0xFF05 ... 0xFF44: //IO Ports
+        case 0xFF05 ... 0xFF07: //Timer registers
+            requestSync();
+            memory[index] = value;
+            break;
+        case 0xFF08 ... 0xFF3F: //IO Ports
+            memory[index] = value;
+            break;
+        case 0xFF40 ... 0xFF44: //LCD registers
+            requestSync();
             memory[index] = value;
             break;
         case 0xFF45: //LYC Compare Register
+            requestSync();
             memory[index] = value;
             if(this->read(LY) == this->read(LYC))
             {
@@ -214,8 +335,13 @@ void GB_MEM::write(unsigned short index, unsigned char value) {
             {
                 memory[0xFE00 + i] = this->read((value << 8) + i);
             }
+            parseSprites();
+            break;
+        case 0xFF47 ... 0xFF49: //Palettes
+            memory[index] = value;
+            paletteDirty = true;
             break;
-        case 0xFF47 ... 0xFF4C: // IO Ports
+        case 0xFF4A ... 0xFF4C: // IO Ports
             memory[index] = value;
             break;
         case 0xFF4D: // CGB KEY1 register - not writable in DMG mode
@@ -230,6 +356,7 @@ void GB_MEM::write(unsigned short index, unsigned char value) {
             break;
         case 0xFF80 ... 0xFFFE: //High RAM
             memory[index] = value;
+            invalidateCode(index);
             break;
         case 0xFFFF: //Interrupt Enable Register
             memory[index] = value;
@@ -282,19 +409,26 @@ void GB_MEM::enableRAMBanks(unsigned short index, unsigned char data) {
     if(MBC2 && ((read(index) & (1 << 4)) == (1 << 4)))
         return;
 
+    bool wasEnabled = enableRam;
     unsigned char testData = data & 0xF;
     if(testData == 0xA)
         enableRam = true;
     else if (testData == 0)
         enableRam = false;
+
+    if(enableRam != wasEnabled)
+        mapRAMBank();
 }
 
 void GB_MEM::changeLoROMBank(unsigned char data) {
+    unsigned char previousBank = currentROMBank;
     if(MBC2)
     {
         currentROMBank = data & 0xF;
         if(currentROMBank == 0)
             currentROMBank++;
+        if(currentROMBank != previousBank)
+            mapROMBank();
         return;
     }
 
@@ -308,9 +442,14 @@ void GB_MEM::changeLoROMBank(unsigned char data) {
 
     if(currentROMBank == 0)
         currentROMBank++;
+
+    if(currentROMBank != previousBank)
+        mapROMBank();
 }
 
 void GB_MEM::changeHiROMBank(unsigned char data) {
+    unsigned char previousBank = currentROMBank;
+
     //Remove upper 3 bits
     currentROMBank &= 0x1F;
 
@@ -320,10 +459,16 @@ void GB_MEM::changeHiROMBank(unsigned char data) {
     currentROMBank |= data;
     if(currentROMBank == 0)
         currentROMBank++;
+
+    if(currentROMBank != previousBank)
+        mapROMBank();
 }
 
 void GB_MEM::changeRAMBank(unsigned char data) {
+    unsigned char previousBank = currentRAMBank;
     currentRAMBank = data & 0x3; //Set ram bank to lower 2 bits of data
+    if(currentRAMBank != previousBank)
+        mapRAMBank();
 }
 
 void GB_MEM::changeROMRAMMode(unsigned char data) {
@@ -333,46 +478,17 @@ void GB_MEM::changeROMRAMMode(unsigned char data) {
     else
         ROMBanking = false;
 
-    if(ROMBanking)
+    if(ROMBanking && currentRAMBank != 0)
+    {
         currentRAMBank = 0;
+        mapRAMBank();
+    }
 }
 
-void GB_MEM::handleButton(const unsigned char *keys) {
-    unsigned char joypadState = memory[0xFF00];
-
-    if(keys[SDL_SCANCODE_UP])
-        pressedButtons &= ~(1 << UP);
-    if(keys[SDL_SCANCODE_DOWN])
-        pressedButtons &= ~(1 << DOWN);
-    if(keys[SDL_SCANCODE_LEFT])
-        pressedButtons &= ~(1 << LEFT);
-    if(keys[SDL_SCANCODE_RIGHT])
-        pressedButtons &= ~(1 << RIGHT);
-    if(keys[SDL_SCANCODE_X])
-        pressedButtons &= ~(1 << (A + 4));
-    if(keys[SDL_SCANCODE_Z])
-        pressedButtons &= ~(1 << (B + 4));
-    if(keys[SDL_SCANCODE_RETURN])
-        pressedButtons &= ~(1 << (START + 4));
-    if(keys[SDL_SCANCODE_RSHIFT])
-        pressedButtons &= ~(1 << (SELECT + 4));
-
-    if(!keys[SDL_SCANCODE_UP])
-        pressedButtons |= (1 << UP);
-    if(!keys[SDL_SCANCODE_DOWN])
-        pressedButtons |= (1 << DOWN);
-    if(!keys[SDL_SCANCODE_LEFT])
-        pressedButtons |= (1 << LEFT);
-    if(!keys[SDL_SCANCODE_RIGHT])
-        pressedButtons |= (1 << RIGHT);
-    if(!keys[SDL_SCANCODE_X])
-        pressedButtons |= (1 << (A + 4));
-    if(!keys[SDL_SCANCODE_Z])
-        pressedButtons |= (1 << (B + 4));
-    if(!keys[SDL_SCANCODE_RETURN])
-        pressedButtons |= (1 << (START + 4));
-    if(!keys[SDL_SCANCODE_RSHIFT])
-        pressedButtons |= (1 << (SELECT + 4));
+void GB_MEM::handleButton(unsigned char pressed) {
+    unsigned char joypadState = read(JOYPAD); //Latch the lines as currently selected
+
+    pressedButtons = ~pressed; //The joypad register is active low
 
     switch((memory[0xFF00] & 0x30) >> 4)
     {
@@ -397,10 +513,16 @@ void GB_MEM::handleButton(const unsigned char *keys) {
     }
 }
 
+void GB_MEM::requestSync() {
+    syncRequested = true;
+    if(syncHandler)
+        syncHandler();
+}
+
 void GB_MEM::updateTimers(int cycles) {
     //Increment Divider
     elapsedDividerCycles += cycles;
-    if (elapsedDividerCycles >= DIV_CYCLES) {
+    while (elapsedDividerCycles >= DIV_CYCLES) {
         elapsedDividerCycles -= DIV_CYCLES;
         memory[0xFF04]++;
     }
@@ -408,22 +530,7 @@ void GB_MEM::updateTimers(int cycles) {
     // If timer enabled
     if (memory[0xFF07] & 0x04) {
         elapsedTimerCycles += cycles;
-        unsigned char timerClock = memory[0xFF07] & 0x03;
-        int cyclesNeeded = 0;
-        switch (timerClock) {
-            case 0:
-                cyclesNeeded = TIM_00_CYCLES;
-                break;
-            case 1:
-                cyclesNeeded = TIM_01_CYCLES;
-                break;
-            case 2:
-                cyclesNeeded = TIM_10_CYCLES;
-                break;
-            case 3:
-                cyclesNeeded = TIM_11_CYCLES;
-                break;
-        }
+        int cyclesNeeded = timerPeriod();
 
         if (elapsedTimerCycles >= cyclesNeeded) {
             elapsedTimerCycles -= cyclesNeeded;
@@ -438,6 +545,25 @@ void GB_MEM::updateTimers(int cycles) {
     }
 }
 
+int GB_MEM::cyclesUntilTimerEvent() {
+    if (memory[0xFF07] & 0x04)
+        return timerPeriod() - elapsedTimerCycles;
+    return (0x100 - memory[0xFF04]) * DIV_CYCLES - elapsedDividerCycles; //Keeps the stopped timers from drifting too far behind
+}
+
+int GB_MEM::timerPeriod() {
+    switch (memory[0xFF07] & 0x03) {
+        case 0:
+            return TIM_00_CYCLES;
+        case 1:
+            return TIM_01_CYCLES;
+        case 2:
+            return TIM_10_CYCLES;
+        default:
+            return TIM_11_CYCLES;
+    }
+}
+
 void GB_MEM::save() {
     if(saving)
     {
@@ -454,6 +580,52 @@ void GB_MEM::save() {
     }
 }
 
+void GB_MEM::serialize(GB_STATE& state) {
+    state.field(memory);
+    state.field(RAMBanks);
+    state.field(currentROMBank);
+    state.field(currentRAMBank);
+    state.field(enableRam);
+    state.field(ROMBanking);
+    state.field(elapsedTimerCycles);
+    state.field(elapsedDividerCycles);
+    state.field(pressedButtons);
+
+    if(state.loading)
+    {
+#ifdef GGBOY_JIT
+        //Any RAM may now hold different code
+        for(int page = 0; page < 0x100; page++)
+        {
+            codePages[page] = false;
+            codeGeneration[page]++;
+        }
+#endif
+        markTilesDirty();
+        parseSprites();
+        paletteDirty = true;
+        updatePageTables();
+    }
+}
+
+void GB_MEM::markTilesDirty() {
+    std::fill(std::begin(tileDirty), std::end(tileDirty), true);
+}
+
+void GB_MEM::parseSprite(unsigned short index) {
+    unsigned short entry = (index - OAM_BEGIN) & ~3;
+    sprite& s = sprites[entry / 4];
+    s.yPos = memory[OAM_BEGIN + entry] - 16;
+    s.xPos = memory[OAM_BEGIN + entry + 1] - 8;
+    s.tileLocation = memory[OAM_BEGIN + entry + 2];
+    s.attributes = memory[OAM_BEGIN + entry + 3];
+}
+
+void GB_MEM::parseSprites() {
+    for(int i = 0; i < SPRITE_COUNT; i++)
+        parseSprite(OAM_BEGIN + i*4);
+}
+
 unsigned char &GB_MEM::operator[](int index) {
     return memory[index];
 }
@@ -0,0 +1,62 @@
+#include "GB_MOVIE.h"
+#include <fstream>
+
+struct movieHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t rom;
+    uint32_t reserved;
+    uint64_t startFrame;
+};
+
+uint64_t GB_MOVIE::endFrame() {
+    return startFrame + buttons.size();
+}
+
+bool GB_MOVIE::save(const std::string& fileName) {
+    movieHeader header = {MAGIC, VERSION, rom, 0, startFrame};
+    std::ofstream file(fileName, std::ios::binary);
+    file.write((char*)&header, sizeof(header));
+    file.write((char*)buttons.data(), buttons.size());
+    return file.good();
+}
+
+bool GB_MOVIE::load(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+    movieHeader header;
+    if(!file.read((char*)&header, sizeof(header)) || header.magic != MAGIC || header.version != VERSION)
+        return false;
+
+    rom = header.rom;
+    startFrame = header.startFrame;
+    buttons.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+GB_RECORDER::GB_RECORDER(GB_INPUT* source, GB_MOVIE& movie) : source(source), movie(movie) {
+}
+
+uint8_t GB_RECORDER::poll(uint64_t frame) {
+    uint8_t pressed = source != nullptr ? source->poll(frame) : 0;
+    if(movie.buttons.empty() || frame < movie.startFrame)
+    {
+        movie.buttons.clear();
+        movie.startFrame = frame;
+    }
+    movie.buttons.resize(frame - movie.startFrame);
+    movie.buttons.push_back(pressed);
+    return pressed;
+}
+
+GB_PLAYER::GB_PLAYER(const GB_MOVIE& movie) : movie(movie) {
+}
+
+uint8_t GB_PLAYER::poll(uint64_t frame) {
+    if(frame < movie.startFrame || frame - movie.startFrame >= movie.buttons.size())
+        return 0;
+    return movie.buttons[frame - movie.startFrame];
+}
+
+bool GB_PLAYER::finished(uint64_t frame) {
+    return frame >= movie.startFrame + movie.buttons.size();
+}
@@ -0,0 +1,203 @@
+#include "GB_PIXELS.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GGBOY_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+static void decodeTileScalar(const uint8_t* data, uint8_t* colors) {
+    for(int y = 0; y < 8; y++)
+    {
+        uint8_t data1 = data[y*2];
+        uint8_t data2 = data[y*2 + 1];
+        for(int x = 0; x < 8; x++)
+        {
+            int colorBit = 7 - x;
+            colors[y*8 + x] = (((data2 >> colorBit) & 1) << 1) | ((data1 >> colorBit) & 1);
+        }
+    }
+}
+
+static void mapColorsScalar(const uint8_t* colors, int count, const uint32_t* palette, uint8_t* out) {
+    for(int i = 0; i < count; i++)
+        memcpy(out + i*4, &palette[colors[i]], 4);
+}
+
+#ifdef GGBOY_X86_KERNELS
+//Sets each byte to value if its bit of the plane is set, leftmost pixel in the highest bit
+__attribute__((target("sse2")))
+static inline __m128i planeBits(__m128i plane, __m128i bits, __m128i value) {
+    return _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(plane, bits), bits), value);
+}
+
+__attribute__((target("sse2")))
+static void decodeTileSSE2(const uint8_t* data, uint8_t* colors) {
+    __m128i rows = _mm_loadu_si128((const __m128i*)data);
+    __m128i lowByte = _mm_set1_epi16(0x00FF);
+    __m128i lo = _mm_packus_epi16(_mm_and_si128(rows, lowByte), _mm_setzero_si128()); //First plane of rows 0-7
+    __m128i hi = _mm_packus_epi16(_mm_srli_epi16(rows, 8), _mm_setzero_si128()); //Second plane of rows 0-7
+
+    //Every plane byte repeated 8 times, two rows per register
+    __m128i lo2 = _mm_unpacklo_epi8(lo, lo);
+    __m128i hi2 = _mm_unpacklo_epi8(hi, hi);
+    __m128i lo4[2] = {_mm_unpacklo_epi16(lo2, lo2), _mm_unpackhi_epi16(lo2, lo2)};
+    __m128i hi4[2] = {_mm_unpacklo_epi16(hi2, hi2), _mm_unpackhi_epi16(hi2, hi2)};
+
+    __m128i bits = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 1, 2, 4, 8, 16, 32, 64, (char)128);
+    __m128i one = _mm_set1_epi8(1);
+    __m128i two = _mm_set1_epi8(2);
+    for(int i = 0; i < 2; i++)
+    {
+        __m128i pair[2][2] = {
+            {_mm_unpacklo_epi32(lo4[i], lo4[i]), _mm_unpacklo_epi32(hi4[i], hi4[i])},
+            {_mm_unpackhi_epi32(lo4[i], lo4[i]), _mm_unpackhi_epi32(hi4[i], hi4[i])}
+        };
+        for(int j = 0; j < 2; j++)
+        {
+            __m128i color = _mm_or_si128(planeBits(pair[j][0], bits, one), planeBits(pair[j][1], bits, two));
+            _mm_storeu_si128((__m128i*)(colors + i*32 + j*16), color);
+        }
+    }
+}
+
+//Without a shuffle the entry is selected by the two bits of each color number, spread over its 32 bit lane
+__attribute__((target("sse2")))
+static inline void storeSelected(uint8_t* out, __m128i mask0, __m128i mask1, const __m128i* entries) {
+    __m128i low = _mm_xor_si128(entries[0], _mm_and_si128(mask0, entries[1]));
+    __m128i high = _mm_xor_si128(entries[2], _mm_and_si128(mask0, entries[3]));
+    _mm_storeu_si128((__m128i*)out, _mm_xor_si128(low, _mm_and_si128(mask1, _mm_xor_si128(low, high))));
+}
+
+__attribute__((target("sse2")))
+static void mapColorsSSE2(const uint8_t* colors, int count, const uint32_t* palette, uint8_t* out) {
+    //First and third entry, and what changes from them to the second and fourth
+    __m128i entries[4] = {
+        _mm_set1_epi32(palette[0]), _mm_set1_epi32(palette[0] ^ palette[1]),
+        _mm_set1_epi32(palette[2]), _mm_set1_epi32(palette[2] ^ palette[3])
+    };
+    __m128i one = _mm_set1_epi8(1);
+    __m128i two = _mm_set1_epi8(2);
+
+    int i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        __m128i color = _mm_loadu_si128((const __m128i*)(colors + i));
+        __m128i bit0 = _mm_cmpeq_epi8(_mm_and_si128(color, one), one);
+        __m128i bit1 = _mm_cmpeq_epi8(_mm_and_si128(color, two), two);
+
+        __m128i bit0Low = _mm_unpacklo_epi8(bit0, bit0);
+        __m128i bit0High = _mm_unpackhi_epi8(bit0, bit0);
+        __m128i bit1Low = _mm_unpacklo_epi8(bit1, bit1);
+        __m128i bit1High = _mm_unpackhi_epi8(bit1, bit1);
+        storeSelected(out + i*4, _mm_unpacklo_epi16(bit0Low, bit0Low), _mm_unpacklo_epi16(bit1Low, bit1Low), entries);
+        storeSelected(out + i*4 + 16, _mm_unpackhi_epi16(bit0Low, bit0Low), _mm_unpackhi_epi16(bit1Low, bit1Low), entries);
+        storeSelected(out + i*4 + 32, _mm_unpacklo_epi16(bit0High, bit0High), _mm_unpacklo_epi16(bit1High, bit1High), entries);
+        storeSelected(out + i*4 + 48, _mm_unpackhi_epi16(bit0High, bit0High), _mm_unpackhi_epi16(bit1High, bit1High), entries);
+    }
+    mapColorsScalar(colors + i, count - i, palette, out + i*4);
+}
+
+__attribute__((target("avx2")))
+static void decodeTileAVX2(const uint8_t* data, uint8_t* colors) {
+    __m256i rows = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)data));
+    __m256i bits = _mm256_set1_epi64x(0x0102040810204080);
+    __m256i one = _mm256_set1_epi8(1);
+    __m256i two = _mm256_set1_epi8(2);
+
+    //Four rows per register, each plane byte repeated over its row
+    for(int i = 0; i < 2; i++)
+    {
+        char row = i*8;
+        __m256i loIndex = _mm256_setr_epi8(
+            row, row, row, row, row, row, row, row, row + 2, row + 2, row + 2, row + 2, row + 2, row + 2, row + 2, row + 2,
+            row + 4, row + 4, row + 4, row + 4, row + 4, row + 4, row + 4, row + 4, row + 6, row + 6, row + 6, row + 6, row + 6, row + 6, row + 6, row + 6);
+        __m256i hiIndex = _mm256_add_epi8(loIndex, one);
+        __m256i lo = _mm256_shuffle_epi8(rows, loIndex);
+        __m256i hi = _mm256_shuffle_epi8(rows, hiIndex);
+        __m256i color = _mm256_or_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(lo, bits), bits), one),
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(hi, bits), bits), two));
+        _mm256_storeu_si256((__m256i*)(colors + i*32), color);
+    }
+}
+
+__attribute__((target("avx2")))
+static void mapColorsAVX2(const uint8_t* colors, int count, const uint32_t* palette, uint8_t* out) {
+    __m256i entries = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)palette));
+
+    int i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(colors + i));
+        __m256i first = _mm256_permutevar8x32_epi32(entries, _mm256_cvtepu8_epi32(bytes));
+        __m256i second = _mm256_permutevar8x32_epi32(entries, _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+        _mm256_storeu_si256((__m256i*)(out + i*4), first);
+        _mm256_storeu_si256((__m256i*)(out + i*4 + 32), second);
+    }
+    if(i + 8 <= count)
+    {
+        __m128i bytes = _mm_loadl_epi64((const __m128i*)(colors + i));
+        _mm256_storeu_si256((__m256i*)(out + i*4), _mm256_permutevar8x32_epi32(entries, _mm256_cvtepu8_epi32(bytes)));
+        i += 8;
+    }
+    mapColorsScalar(colors + i, count - i, palette, out + i*4);
+}
+#endif
+
+static GB_PIXELS::level selected = GB_PIXELS::SCALAR;
+
+void (*GB_PIXELS::decodeTile)(const uint8_t* data, uint8_t* colors) = decodeTileScalar;
+void (*GB_PIXELS::mapColors)(const uint8_t* colors, int count, const uint32_t* palette, uint8_t* out) = mapColorsScalar;
+
+//Picked once at load time, before any emulator thread can call a kernel
+static const bool kernelsPicked = (GB_PIXELS::use(GB_PIXELS::best()), true);
+
+GB_PIXELS::level GB_PIXELS::best() {
+#ifdef GGBOY_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return AVX2;
+    if(__builtin_cpu_supports("sse2"))
+        return SSE2;
+#endif
+    return SCALAR;
+}
+
+void GB_PIXELS::use(level wanted) {
+    level supported = best();
+    selected = wanted < supported ? wanted : supported;
+    switch(selected)
+    {
+#ifdef GGBOY_X86_KERNELS
+        case AVX2:
+            decodeTile = decodeTileAVX2;
+            mapColors = mapColorsAVX2;
+            break;
+        case SSE2:
+            decodeTile = decodeTileSSE2;
+            mapColors = mapColorsSSE2;
+            break;
+#endif
+        default:
+            decodeTile = decodeTileScalar;
+            mapColors = mapColorsScalar;
+            break;
+    }
+}
+
+GB_PIXELS::level GB_PIXELS::current() {
+    return selected;
+}
+
+const char* GB_PIXELS::name(level l) {
+    switch(l)
+    {
+        case AVX2:
+            return "avx2";
+        case SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
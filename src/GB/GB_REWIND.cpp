@@ -0,0 +1,194 @@
+#include "GB_REWIND.h"
+
+GB_REWIND::GB_REWIND(GB& gameboy, int interval, int keyframeInterval, size_t budget)
+    : gameboy(gameboy), interval(std::max(interval, 1)), keyframeInterval(std::max(keyframeInterval, 1)), budget(budget) {
+}
+
+void GB_REWIND::capture() {
+    if(!history.empty() && gameboy.frames < history.back().frame + interval)
+        return;
+
+    gameboy.saveState(state);
+
+    snapshot taken;
+    taken.frame = gameboy.frames;
+    if(!spare.empty())
+    {
+        taken.data = std::move(spare.back());
+        spare.pop_back();
+        taken.data.clear();
+    }
+
+    //States only change size with the format version, but a new keyframe keeps this safe
+    taken.keyframe = sinceKeyframe == 0 || keyframe.size() != state.size();
+    if(taken.keyframe)
+    {
+        encode(state.data(), nullptr, state.size(), taken.data);
+        keyframe = state;
+        sinceKeyframe = 0;
+    }
+    else
+        encode(state.data(), keyframe.data(), state.size(), taken.data);
+    sinceKeyframe = (sinceKeyframe + 1) % keyframeInterval;
+
+    used += taken.data.size();
+    history.push_back(std::move(taken));
+
+    //The newest keyframe and its deltas are always kept, even over budget
+    while(used > budget && !history.empty())
+    {
+        size_t next = 1;
+        while(next < history.size() && !history[next].keyframe)
+            next++;
+        if(next == history.size())
+            break;
+        dropOldest();
+    }
+}
+
+bool GB_REWIND::rewind(uint64_t frame) {
+    size_t index = history.size();
+    while(index > 0 && history[index - 1].frame > frame)
+        index--;
+    if(index == 0)
+        return false;
+    index--;
+
+    restore(index);
+    if(!gameboy.loadState(state))
+        return false;
+
+    //Snapshots after the restored one belong to a future that won't happen anymore
+    while(history.size() > index + 1)
+    {
+        used -= history.back().data.size();
+        spare.push_back(std::move(history.back().data));
+        history.pop_back();
+    }
+    return true;
+}
+
+bool GB_REWIND::stepBack() {
+    if(gameboy.frames == 0)
+        return false;
+    return rewind(gameboy.frames - 1);
+}
+
+uint64_t GB_REWIND::oldestFrame() {
+    return history.empty() ? 0 : history.front().frame;
+}
+
+uint64_t GB_REWIND::newestFrame() {
+    return history.empty() ? 0 : history.back().frame;
+}
+
+size_t GB_REWIND::memoryUsed() {
+    return used;
+}
+
+void GB_REWIND::clear() {
+    history.clear();
+    spare.clear();
+    used = 0;
+    sinceKeyframe = 0;
+}
+
+void GB_REWIND::dropOldest() {
+    do
+    {
+        used -= history.front().data.size();
+        if(spare.size() < (size_t)keyframeInterval)
+            spare.push_back(std::move(history.front().data));
+        history.pop_front();
+    } while(!history.empty() && !history.front().keyframe);
+}
+
+void GB_REWIND::restore(size_t index) {
+    size_t key = index;
+    while(!history[key].keyframe)
+        key--;
+
+    size_t size = state.size();
+    keyframe.assign(size, 0);
+    decode(history[key].data, keyframe.data(), size);
+    state = keyframe;
+    if(key != index)
+        decode(history[index].data, state.data(), size);
+
+    //New deltas are taken against the restored keyframe
+    sinceKeyframe = (index - key + 1) % keyframeInterval;
+}
+
+static void writeVarint(std::vector<uint8_t>& out, size_t value) {
+    while(value >= 0x80)
+    {
+        out.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+static size_t readVarint(const std::vector<uint8_t>& in, size_t& position) {
+    size_t value = 0;
+    int shift = 0;
+    while(position < in.size())
+    {
+        uint8_t byte = in[position++];
+        value |= (size_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+            break;
+        shift += 7;
+    }
+    return value;
+}
+
+void GB_REWIND::encode(const uint8_t* current, const uint8_t* base, size_t size, std::vector<uint8_t>& out) {
+    auto changed = [current, base](size_t i) -> uint8_t { return base != nullptr ? current[i] ^ base[i] : current[i]; };
+
+    //Pairs of unchanged run length and changed bytes, a changed run ends at the next 8 unchanged bytes
+    size_t i = 0;
+    while(i < size)
+    {
+        size_t start = i;
+        while(i + 8 <= size)
+        {
+            uint64_t a, b = 0;
+            memcpy(&a, current + i, 8);
+            if(base != nullptr)
+                memcpy(&b, base + i, 8);
+            if(a != b)
+                break;
+            i += 8;
+        }
+        while(i < size && changed(i) == 0)
+            i++;
+        writeVarint(out, i - start);
+
+        size_t end = i;
+        int unchanged = 0;
+        while(end < size && unchanged < 8)
+        {
+            unchanged = changed(end) == 0 ? unchanged + 1 : 0;
+            end++;
+        }
+        end -= unchanged;
+
+        writeVarint(out, end - i);
+        for(; i < end; i++)
+            out.push_back(changed(i));
+    }
+}
+
+void GB_REWIND::decode(const std::vector<uint8_t>& in, uint8_t* out, size_t size) {
+    size_t position = 0;
+    size_t i = 0;
+    while(position < in.size())
+    {
+        i += readVarint(in, position);
+        size_t length = readVarint(in, position);
+        if(i + length > size || position + length > in.size())
+            return;
+        for(size_t end = i + length; i < end; i++)
+            out[i] ^= in[position++];
+    }
+}
@@ -0,0 +1,32 @@
+#include "GB_RUNAHEAD.h"
+
+GB_RUNAHEAD::GB_RUNAHEAD(GB& gameboy, int frames) : frames(frames), gameboy(gameboy) {
+}
+
+bool GB_RUNAHEAD::runFrame() {
+    if(frames <= 0)
+        return gameboy.runFrame();
+
+    //The real frame is drawn, so the screen saved in states stays right, but not presented
+    std::function<void()> present = std::move(gameboy.gpu.frameHandler);
+    gameboy.gpu.frameHandler = nullptr;
+    bool running = gameboy.runFrame();
+    gameboy.saveState(state);
+
+    std::function<void()> frameEnd = std::move(gameboy.frameHandler);
+    gameboy.frameHandler = nullptr;
+    for(int i = 0; i < frames && running; i++)
+    {
+        bool last = i == frames - 1;
+        gameboy.gpu.skipRendering = !last;
+        if(last)
+            gameboy.gpu.frameHandler = present;
+        running = gameboy.runFrame();
+    }
+
+    gameboy.gpu.skipRendering = false;
+    gameboy.gpu.frameHandler = std::move(present);
+    gameboy.frameHandler = std::move(frameEnd);
+    gameboy.loadState(state);
+    return running;
+}
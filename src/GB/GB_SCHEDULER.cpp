@@ -0,0 +1,69 @@
+#include "GB_SCHEDULER.h"
+#include <algorithm>
+#include <climits>
+
+GB_SCHEDULER::GB_SCHEDULER() {
+    for(int i = 0; i < EVENT_COUNT; i++)
+        times[i] = NEVER;
+}
+
+void GB_SCHEDULER::setHandler(event type, std::function<void(uint64_t)> handler) {
+    handlers[type] = handler;
+}
+
+void GB_SCHEDULER::schedule(event type, uint64_t time) {
+    times[type] = time;
+}
+
+void GB_SCHEDULER::scheduleIn(event type, int cycles) {
+    times[type] = now + std::max(cycles, 0);
+}
+
+void GB_SCHEDULER::cancel(event type) {
+    times[type] = NEVER;
+}
+
+uint64_t GB_SCHEDULER::timeOf(event type) {
+    return times[type];
+}
+
+int GB_SCHEDULER::cyclesUntilNextEvent() {
+    uint64_t next = NEVER;
+    for(int i = 0; i < EVENT_COUNT; i++)
+        next = std::min(next, times[i]);
+
+    if(next <= now)
+        return 0;
+    return (int)std::min<uint64_t>(next - now, INT_MAX);
+}
+
+void GB_SCHEDULER::serialize(GB_STATE& state) {
+    state.field(now);
+    state.field(times);
+}
+
+void GB_SCHEDULER::advance(int cycles) {
+    now += cycles;
+
+    bool ran[EVENT_COUNT] = {};
+    dispatching = true;
+    while(true)
+    {
+        //Few event types, so a scan is cheaper than keeping a heap
+        int next = -1;
+        for(int i = 0; i < EVENT_COUNT; i++)
+        {
+            if(!ran[i] && times[i] <= now && (next == -1 || times[i] < times[next]))
+                next = i;
+        }
+        if(next == -1)
+            break;
+
+        uint64_t time = times[next];
+        ran[next] = true;
+        times[next] = NEVER;
+        if(handlers[next])
+            handlers[next](time);
+    }
+    dispatching = false;
+}
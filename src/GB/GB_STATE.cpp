@@ -0,0 +1,42 @@
+#include "GB_STATE.h"
+
+GB_STATE::GB_STATE(std::vector<uint8_t>& data, size_t start) : loading(false), output(&data), position(start) {
+}
+
+GB_STATE::GB_STATE(const uint8_t* data, size_t size) : loading(true), input(data), inputSize(size) {
+}
+
+GB_STATE::GB_STATE() : loading(false) {
+}
+
+size_t GB_STATE::size() {
+    return position;
+}
+
+uint64_t GB_STATE::checksum(const uint8_t* data, size_t size) {
+    //Four independent lanes so the multiplies overlap
+    uint64_t lanes[4] = {0xcbf29ce484222325 ^ size, 0x84222325cbf29ce4, 0x9ce484222325cbf2, 0x2325cbf29ce48422};
+    size_t i = 0;
+    for(; i + 32 <= size; i += 32)
+    {
+        for(int lane = 0; lane < 4; lane++)
+        {
+            uint64_t word;
+            memcpy(&word, data + i + lane * 8, 8);
+            lanes[lane] = (lanes[lane] ^ word) * 0x100000001b3;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+
+    uint64_t hash = lanes[0] ^ (lanes[1] * 3) ^ (lanes[2] * 5) ^ (lanes[3] * 7);
+    for(; i < size; i++)
+        hash = (hash ^ data[i]) * 0x100000001b3;
+    return hash;
+}
+
+uint32_t GB_STATE::romId(const std::vector<unsigned char>& rom) {
+    //Title, licensee, type and checksums of the cartridge header
+    if(rom.size() < 0x150)
+        return 0;
+    return (uint32_t)checksum(&rom[0x134], 0x150 - 0x134);
+}
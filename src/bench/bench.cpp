@@ -0,0 +1,323 @@
+#include "GB.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+//Fixed workloads run headless and uncapped
+//  ggboy_bench [--frames n] [--repeat n] [--json] [--filter name] [--kernels scalar|sse2|avx2] [rom.gb...]
+//Every workload is run --repeat times and the fastest run is reported
+//--kernels caps the pixel kernels used by the renderer, by default the best ones the cpu supports are
+
+//Tiny assembler for the synthetic roms
+struct romBuilder {
+    std::vector<unsigned char> rom;
+    uint16_t pc = 0;
+
+    romBuilder(unsigned char cartType, unsigned char romSize) : rom(0x8000 << romSize, 0) {
+        rom[0x147] = cartType;
+        rom[0x148] = romSize;
+        for(int i = 0x134; i < 0x14D; i++) //Header checksum, checked by GB_MEM::loadRom
+            rom[0x14D] = rom[0x14D] - rom[i] - 1;
+        at(0x0040).emit({0xD9}); //RETI from every interrupt vector used
+        at(0x0048).emit({0xD9});
+        at(0x0050).emit({0xD9});
+        at(0x0100).emit({0x00, 0xC3, 0x50, 0x01}); //NOP, JP 0x0150
+        at(0x0150);
+    }
+
+    romBuilder& at(uint16_t address) {
+        pc = address;
+        return *this;
+    }
+
+    romBuilder& emit(std::initializer_list<unsigned char> bytes) {
+        for(unsigned char byte : bytes)
+            rom[pc++] = byte;
+        return *this;
+    }
+
+    //Bytes of a banked routine, address is in 0x4000-0x7FFF
+    romBuilder& emitBanked(unsigned int bank, uint16_t address, std::initializer_list<unsigned char> bytes) {
+        size_t offset = bank * 0x4000 + address - 0x4000;
+        for(unsigned char byte : bytes)
+            rom[offset++] = byte;
+        return *this;
+    }
+
+    //JR to a label emitted earlier, op being 0x18 or a conditional JR
+    romBuilder& jr(unsigned char op, uint16_t label) {
+        return emit({op, (unsigned char)(label - (pc + 2))});
+    }
+
+    romBuilder& jp(uint16_t label) {
+        return emit({0xC3, (unsigned char)(label & 0xFF), (unsigned char)(label >> 8)});
+    }
+
+    romBuilder& ldh(unsigned char reg, unsigned char value) {
+        return emit({0x3E, value, 0xE0, reg}); //LD A,value - LDH (reg),A
+    }
+
+    romBuilder& lcdOff() {
+        return emit({0xAF, 0xE0, 0x40}); //XOR A - LDH (LCDC),A
+    }
+};
+
+//Register and ALU operations only, lcd off
+static std::vector<unsigned char> aluRom() {
+    romBuilder r(0x00, 0x00);
+    r.lcdOff();
+    uint16_t loop = r.pc;
+    r.emit({
+        0x3C, //INC A
+        0x80, //ADD A,B
+        0xA9, //XOR C
+        0x47, //LD B,A
+        0x0C, //INC C
+        0x91, //SUB C
+        0xB2, //OR D
+        0x57, //LD D,A
+        0x1D, //DEC E
+        0xCB, 0x37, //SWAP A
+        0xCB, 0x11, //RL C
+        0x2F, //CPL
+        0x23, //INC HL
+        0x09, //ADD HL,BC
+        0x8B, //ADC A,E
+        0xE6, 0x7F, //AND 0x7F
+    });
+    r.jr(0x20, loop); //JR NZ
+    r.jp(loop);
+    return r.rom;
+}
+
+//Work RAM loads and stores, stack and calls, lcd off
+static std::vector<unsigned char> memoryRom() {
+    romBuilder r(0x00, 0x00);
+    r.lcdOff();
+    r.emit({0x31, 0xFE, 0xDF}); //LD SP,0xDFFE
+    uint16_t loop = r.pc;
+    r.emit({0x21, 0x00, 0xC0, 0x06, 0x00}); //LD HL,0xC000 - LD B,0
+    uint16_t inner = r.pc;
+    uint16_t function = 0x0300;
+    r.emit({
+        0x22, //LD (HL+),A
+        0x7E, //LD A,(HL)
+        0xC5, //PUSH BC
+        0xCD, (unsigned char)(function & 0xFF), (unsigned char)(function >> 8), //CALL function
+        0xC1, //POP BC
+        0x34, //INC (HL)
+        0x05, //DEC B
+    });
+    r.jr(0x20, inner); //JR NZ
+    r.jr(0x18, loop);
+    r.at(function).emit({0x3C, 0x5F, 0xC9}); //INC A - LD E,A - RET
+    return r.rom;
+}
+
+//Background, window and 40 sprites on screen, the cpu halts until every vblank and scrolls
+static std::vector<unsigned char> ppuRom() {
+    romBuilder r(0x00, 0x00);
+    r.lcdOff();
+
+    //Tile data and both maps
+    r.emit({0x21, 0x00, 0x80}); //LD HL,0x8000
+    uint16_t fill = r.pc;
+    r.emit({0x7D, 0xAC, 0x22, 0x7C, 0xFE, 0xA0}); //LD A,L - XOR H - LD (HL+),A - LD A,H - CP 0xA0
+    r.jr(0x20, fill);
+
+    //Sprites spread over the screen
+    r.emit({0x21, 0x00, 0xFE}); //LD HL,0xFE00
+    uint16_t oam = r.pc;
+    r.emit({0x7D, 0x87, 0x87, 0xC6, 0x10, 0x22, 0x7D, 0xFE, 0xA0}); //LD A,L - ADD A,A - ADD A,A - ADD A,0x10 - LD (HL+),A - LD A,L - CP 0xA0
+    r.jr(0x20, oam);
+
+    r.ldh(0x47, 0xE4); //BGP
+    r.ldh(0x48, 0xD2); //OBP0
+    r.ldh(0x49, 0x1B); //OBP1
+    r.ldh(0x4A, 0x48); //WY
+    r.ldh(0x4B, 0x50); //WX
+    r.ldh(0xFF, 0x01); //IE, vblank only
+    r.ldh(0x40, 0xF3); //LCDC, lcd, window, background and sprites on
+    r.emit({0xFB}); //EI
+
+    uint16_t frame = r.pc;
+    r.emit({0x76, 0x00}); //HALT
+    r.emit({0xF0, 0x43, 0x3C, 0xE0, 0x43, 0xE0, 0x42}); //LDH A,(SCX) - INC A - LDH (SCX),A - LDH (SCY),A
+    r.jr(0x18, frame);
+    return r.rom;
+}
+
+//MBC1 rom switching bank before every call into the switchable area
+static std::vector<unsigned char> bankSwitchRom() {
+    const unsigned char banks = 32;
+    romBuilder r(0x01, 0x04);
+    r.lcdOff();
+    r.emit({0x31, 0xFE, 0xDF}); //LD SP,0xDFFE
+    uint16_t loop = r.pc;
+    r.emit({
+        0x04, //INC B
+        0x78, //LD A,B
+        0xE6, banks - 1, //AND banks - 1
+        0x47, //LD B,A
+        0xEA, 0x00, 0x20, //LD (0x2000),A
+        0xCD, 0x00, 0x40, //CALL 0x4000
+    });
+    r.jr(0x18, loop);
+
+    for(unsigned int bank = 1; bank < banks; bank++)
+    {
+        r.emitBanked(bank, 0x4000, {0xFA, 0x00, 0x41, 0x81, 0x4F, 0xC9}); //LD A,(0x4100) - ADD A,C - LD C,A - RET
+        r.emitBanked(bank, 0x4100, {(unsigned char)bank});
+    }
+    return r.rom;
+}
+
+struct workload {
+    std::string name;
+    std::vector<unsigned char> rom;
+};
+
+struct result {
+    double seconds = 0;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t frames = 0;
+};
+
+//Quotes, backslashes and control characters escaped for a JSON string
+static std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for(unsigned char c : text)
+    {
+        if(c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if(c < 0x20)
+        {
+            char code[7];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        }
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+static result runWorkload(const workload& w, uint64_t frames) {
+    GB gameboy(w.rom, false);
+    auto begin = std::chrono::steady_clock::now();
+    while(gameboy.frames < frames)
+    {
+        if(!gameboy.runFrame())
+            break;
+    }
+    result r;
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    r.cycles = gameboy.scheduler.now;
+    r.instructions = gameboy.cpu.instructionCount;
+    r.frames = gameboy.frames;
+    return r;
+}
+
+int main(int argc, char* argv[])
+{
+    uint64_t frames = 600;
+    int repeat = 3;
+    bool json = false;
+    std::string filter;
+    std::vector<workload> workloads = {
+        {"cpu_alu", aluRom()},
+        {"cpu_memory", memoryRom()},
+        {"ppu_scene", ppuRom()},
+        {"bank_switch", bankSwitchRom()},
+    };
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = atoll(argv[++i]);
+        else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+            repeat = std::max(1, atoi(argv[++i]));
+        else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if(strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if(strcmp(argv[i], "--kernels") == 0 && i + 1 < argc)
+        {
+            std::string level = argv[++i];
+            if(level != "scalar" && level != "sse2" && level != "avx2")
+            {
+                std::cerr << "Unknown kernels " << level << ", expected scalar, sse2 or avx2" << std::endl;
+                return 1;
+            }
+            GB_PIXELS::use(level == "scalar" ? GB_PIXELS::SCALAR : level == "sse2" ? GB_PIXELS::SSE2 : GB_PIXELS::AVX2);
+        }
+        else
+        {
+            std::ifstream rom(argv[i], std::ios::binary);
+            if(!rom)
+            {
+                std::cerr << "Could not open " << argv[i] << std::endl;
+                return 1;
+            }
+            workloads.push_back({argv[i], std::vector<unsigned char>(std::istreambuf_iterator<char>(rom), {})});
+            if(!GB(workloads.back().rom, false).loaded)
+            {
+                std::cerr << argv[i] << " is not a gameboy rom" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    if(json)
+        std::cout << "[\n";
+    else
+        std::cout << "pixel kernels: " << GB_PIXELS::name(GB_PIXELS::current()) << "\n"
+                  << std::left << std::setw(16) << "workload" << std::right << std::setw(8) << "frames" << std::setw(12) << "MHz"
+                  << std::setw(14) << "ns/frame" << std::setw(12) << "MIPS" << std::setw(10) << "speed" << "\n";
+
+    bool first = true;
+    for(const workload& w : workloads)
+    {
+        if(!filter.empty() && w.name.find(filter) == std::string::npos)
+            continue;
+
+        result best;
+        for(int i = 0; i < repeat; i++)
+        {
+            result r = runWorkload(w, frames);
+            if(i == 0 || r.seconds < best.seconds)
+                best = r;
+        }
+
+        //Nothing runs with --frames 0, rates are reported as 0 rather than inf or nan
+        double cyclesPerSecond = best.seconds > 0 ? best.cycles / best.seconds : 0;
+        double nsPerFrame = best.frames > 0 ? best.seconds * 1e9 / best.frames : 0;
+        double instructionsPerSecond = best.seconds > 0 ? best.instructions / best.seconds : 0;
+        double speed = cyclesPerSecond / (CYCLES_PER_FRAME * 59.7275); //Multiple of real hardware speed
+
+        if(json)
+        {
+            std::cout << (first ? "" : ",\n") << std::fixed << std::setprecision(1)
+                      << "  {\"workload\": \"" << jsonEscape(w.name) << "\", \"frames\": " << best.frames << ", \"cycles\": " << best.cycles
+                      << ", \"instructions\": " << best.instructions << ", \"seconds\": " << std::setprecision(6) << best.seconds
+                      << std::setprecision(1) << ", \"cycles_per_second\": " << cyclesPerSecond << ", \"ns_per_frame\": " << nsPerFrame
+                      << ", \"instructions_per_second\": " << instructionsPerSecond
+                      << ", \"kernels\": \"" << GB_PIXELS::name(GB_PIXELS::current()) << "\"}";
+        }
+        else
+        {
+            std::cout << std::left << std::setw(16) << w.name << std::right << std::setw(8) << best.frames << std::fixed << std::setprecision(2)
+                      << std::setw(12) << cyclesPerSecond / 1e6 << std::setprecision(0) << std::setw(14) << nsPerFrame << std::setprecision(2)
+                      << std::setw(12) << instructionsPerSecond / 1e6 << std::setprecision(1) << std::setw(9) << speed << "x\n";
+        }
+        first = false;
+    }
+
+    if(json)
+        std::cout << "\n]" << std::endl;
+    return 0;
+}
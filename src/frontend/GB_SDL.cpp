@@ -0,0 +1,214 @@
+#include "GB_SDL.h"
+#include <cmath>
+#include <thread>
+
+GB_SDL::GB_SDL(GB& gameboy) : gameboy(gameboy), rewind(gameboy), runAhead(gameboy) {
+    //Initialize SDL
+    if( SDL_Init( SDL_INIT_VIDEO ) < 0 )
+    {
+        printf( "SDL could not initialize! SDL_Error: %s\n", SDL_GetError() );
+    }
+    else
+    {
+        //Create window
+        window = SDL_CreateWindow( "Gameboy Emulator", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 160*scale, 144*scale, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE );
+        if( window == nullptr )
+        {
+            printf( "Window could not be created! SDL_Error: %s\n", SDL_GetError() );
+        }
+        else
+        {
+            //Vsync only holds back the window thread, the emulator is paced by endFrame
+            renderer = SDL_CreateRenderer( window, -1, SDL_RENDERER_PRESENTVSYNC );
+            if( renderer == nullptr )
+            {
+                SDL_Log("SDL_CreateRenderer() failed: %s", SDL_GetError());
+                exit(1);
+            }
+            SDL_RenderSetLogicalSize( renderer, 160, 144 );
+            SDL_SetRenderDrawColor( renderer, 0x0, 0x0, 0x0, 0xFF );
+            SDL_RenderClear( renderer );
+            SDL_RenderPresent( renderer );
+
+            //Same byte order as GB_GPU::screen, its fourth byte is ignored
+            texture = SDL_CreateTexture( renderer, SDL_PIXELFORMAT_BGRA32, SDL_TEXTUREACCESS_STREAMING, 160, 144 );
+            if( texture == nullptr )
+            {
+                SDL_Log("SDL_CreateTexture() failed: %s", SDL_GetError());
+                exit(1);
+            }
+            SDL_SetTextureBlendMode( texture, SDL_BLENDMODE_NONE );
+        }
+    }
+
+    gameboy.gpu.setOutput(mailbox.back()[0][0], sizeof(mailbox.back()[0]));
+    gameboy.gpu.frameHandler = [this]() { drawFrame(); };
+    gameboy.frameHandler = [this]() { endFrame(); };
+    gameboy.input = this;
+}
+
+GB_SDL::~GB_SDL() {
+    gameboy.gpu.setOutput(nullptr, 0);
+    gameboy.gpu.frameHandler = nullptr;
+    gameboy.frameHandler = nullptr;
+    if(gameboy.input == this)
+        gameboy.input = nullptr;
+
+    if(texture != nullptr)
+        SDL_DestroyTexture(texture);
+    if(renderer != nullptr)
+        SDL_DestroyRenderer(renderer);
+    if(window != nullptr)
+        SDL_DestroyWindow(window);
+    SDL_Quit();
+}
+
+void GB_SDL::run(long frames) {
+    finished = false;
+    stopping = false;
+    handleEvents();
+    std::thread emulator(&GB_SDL::emulate, this, frames);
+
+    while(!finished && !stopping)
+    {
+        handleEvents();
+        if(!present())
+            SDL_Delay(1);
+    }
+
+    stopping = true;
+    emulator.join();
+    present();
+    gameboy.quit = true;
+}
+
+void GB_SDL::emulate(long frames) {
+    nextFrame = std::chrono::steady_clock::now();
+    while(!stopping && (frames < 0 || gameboy.frames < (uint64_t)frames))
+    {
+        if(rewinding)
+        {
+            if(rewind.stepBack())
+                drawFrame();
+            endFrame();
+            continue;
+        }
+
+        //Running ahead only helps at normal speed
+        if(!(fastForward ? gameboy.runFrame() : runAhead.runFrame()))
+            break;
+        rewind.capture();
+    }
+    finished = true;
+}
+
+void GB_SDL::drawFrame() {
+    GB_GPU& gpu = gameboy.gpu;
+
+    //The window already shows this frame, or will once it takes the last one published
+    if(!gpu.screenChanged)
+        return;
+    gpu.clearDirtyLines();
+
+    //Lines were skipped or a state was loaded since the last frame
+    if(gpu.outputLines != 144)
+        memcpy(mailbox.back(), gpu.screen, sizeof(gpu.screen));
+
+    mailbox.publish();
+    gpu.setOutput(mailbox.back()[0][0], sizeof(mailbox.back()[0]));
+}
+
+void GB_SDL::endFrame() {
+    using namespace std::chrono;
+    steady_clock::time_point now = steady_clock::now();
+    bool fast = fastForward;
+    double speed = fast ? turboSpeed : 1;
+
+    //Draw about SCREEN_FPS frames a second whatever the speed
+    if(!fast)
+    {
+        gameboy.gpu.frameSkip = 0;
+        measuredFrames = 0;
+        measureStart = now;
+    }
+    else if(speed > 0)
+        gameboy.gpu.frameSkip = (int)std::ceil(speed) - 1;
+    else
+    {
+        //Uncapped, the speed is measured every quarter second
+        measuredFrames++;
+        if(now - measureStart >= milliseconds(250))
+        {
+            double framesPerSecond = measuredFrames / duration<double>(now - measureStart).count();
+            gameboy.gpu.frameSkip = std::max(0, (int)(framesPerSecond / SCREEN_FPS) - 1);
+            measuredFrames = 0;
+            measureStart = now;
+        }
+    }
+
+    if(speed <= 0)
+    {
+        nextFrame = now;
+        return;
+    }
+
+    //If frame finished early wait the remaining time, if far behind don't try to catch up
+    nextFrame += duration_cast<steady_clock::duration>(duration<double>(1.0 / (SCREEN_FPS * speed)));
+    if(nextFrame > now)
+        std::this_thread::sleep_until(nextFrame);
+    else if(now - nextFrame > milliseconds(100))
+        nextFrame = now;
+}
+
+bool GB_SDL::present() {
+    const GB_MAILBOX::frame* frame = mailbox.take();
+    if(frame == nullptr || texture == nullptr)
+        return false;
+
+    SDL_UpdateTexture(texture, NULL, *frame, sizeof((*frame)[0]));
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+    SDL_RenderPresent(renderer);
+    return true;
+}
+
+void GB_SDL::handleEvents() {
+    SDL_Event e;
+    while(SDL_PollEvent(&e) != 0)
+    {
+        //User requests quit
+        if(e.type == SDL_QUIT)
+            stopping = true;
+    }
+
+    buttons = readButtons();
+    const unsigned char* keys = SDL_GetKeyboardState(NULL);
+    rewinding = keys[SDL_SCANCODE_BACKSPACE] != 0;
+    fastForward = keys[SDL_SCANCODE_TAB] != 0;
+}
+
+uint8_t GB_SDL::readButtons() {
+    const unsigned char* keys = SDL_GetKeyboardState(NULL);
+    uint8_t pressed = 0;
+    if(keys[SDL_SCANCODE_UP])
+        pressed |= 1 << GB_MEM::UP;
+    if(keys[SDL_SCANCODE_DOWN])
+        pressed |= 1 << GB_MEM::DOWN;
+    if(keys[SDL_SCANCODE_LEFT])
+        pressed |= 1 << GB_MEM::LEFT;
+    if(keys[SDL_SCANCODE_RIGHT])
+        pressed |= 1 << GB_MEM::RIGHT;
+    if(keys[SDL_SCANCODE_X])
+        pressed |= 1 << (GB_MEM::A + 4);
+    if(keys[SDL_SCANCODE_Z])
+        pressed |= 1 << (GB_MEM::B + 4);
+    if(keys[SDL_SCANCODE_RETURN])
+        pressed |= 1 << (GB_MEM::START + 4);
+    if(keys[SDL_SCANCODE_RSHIFT])
+        pressed |= 1 << (GB_MEM::SELECT + 4);
+    return pressed;
+}
+
+uint8_t GB_SDL::poll(uint64_t) {
+    return buttons;
+}
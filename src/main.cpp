@@ -1,10 +1,141 @@
 #define SDL_MAIN_HANDLED
-#include "GB.h"
+#include "GB_SDL.h"
+#include "GB_MOVIE.h"
+#include <array>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+//A built in theme name, or four colors from lightest to darkest as RRGGBB separated by commas
+static bool parseTheme(const std::string& text, uint32_t colors[4])
+{
+    static const std::map<std::string, std::array<uint32_t, 4>> themes = {
+        {"gray", {0xFFFFFF, 0xCCCCCC, 0x777777, 0x000000}},
+        {"green", {0x9BBC0F, 0x8BAC0F, 0x306230, 0x0F380F}},
+        {"pocket", {0xC4CFA1, 0x8B956D, 0x4D533C, 0x1F1F1F}},
+    };
+    auto theme = themes.find(text);
+    if(theme != themes.end())
+    {
+        std::copy(theme->second.begin(), theme->second.end(), colors);
+        return true;
+    }
+
+    std::stringstream list(text);
+    std::string color;
+    int count = 0;
+    while(std::getline(list, color, ','))
+    {
+        char* end;
+        unsigned long value = strtoul(color.c_str(), &end, 16);
+        if(count == 4 || color.size() != 6 || *end != 0)
+            return false;
+        colors[count++] = value;
+    }
+    return count == 4;
+}
 
 int main(int argc, char* argv[])
 {
-  	GB gameboy(argv[1]);
-	gameboy.execute();
-    gameboy.mem->save();
-	return 0;
-}
\ No newline at end of file
+    //GGBoy [--headless] [--frames n] [--load-state file] [--save-state file] [--run-ahead n] [--record file | --play file] [--theme name] [--turbo speed] rom.gb
+    bool headless = false;
+    long frames = -1;
+    int runAhead = 0;
+    double turbo = 0;
+    std::string rom, loadState, saveState, record, play, theme;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = atol(argv[++i]);
+        else if(strcmp(argv[i], "--run-ahead") == 0 && i + 1 < argc)
+            runAhead = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            record = argv[++i];
+        else if(strcmp(argv[i], "--play") == 0 && i + 1 < argc)
+            play = argv[++i];
+        else if(strcmp(argv[i], "--load-state") == 0 && i + 1 < argc)
+            loadState = argv[++i];
+        else if(strcmp(argv[i], "--save-state") == 0 && i + 1 < argc)
+            saveState = argv[++i];
+        else if(strcmp(argv[i], "--theme") == 0 && i + 1 < argc)
+            theme = argv[++i];
+        else if(strcmp(argv[i], "--turbo") == 0 && i + 1 < argc)
+            turbo = atof(argv[++i]);
+        else
+            rom = argv[i];
+    }
+
+  	GB gameboy(rom);
+    if(!gameboy.loaded)
+    {
+        std::cout << "Could not load rom " << rom << std::endl;
+        return 1;
+    }
+    if(!theme.empty())
+    {
+        uint32_t colors[4];
+        if(!parseTheme(theme, colors))
+        {
+            std::cout << "Unknown theme " << theme << std::endl;
+            return 1;
+        }
+        gameboy.gpu.setTheme(colors);
+    }
+    if(!loadState.empty() && !gameboy.loadStateFile(loadState))
+    {
+        std::cout << "Could not load state " << loadState << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<GB_SDL> frontend;
+    if(!headless)
+    {
+        frontend = std::make_unique<GB_SDL>(gameboy);
+        frontend->runAhead.frames = runAhead;
+        frontend->turboSpeed = turbo;
+    }
+
+    //Movies wrap or replace the keyboard
+    GB_MOVIE movie;
+    std::unique_ptr<GB_INPUT> movieInput;
+    uint32_t romId = GB_STATE::romId(gameboy.mem.fullRom);
+    if(!play.empty())
+    {
+        if(!movie.load(play) || movie.rom != romId)
+        {
+            std::cout << "Could not play " << play << " on this rom" << std::endl;
+            return 1;
+        }
+        movieInput = std::make_unique<GB_PLAYER>(movie);
+        gameboy.input = movieInput.get();
+        if(frames < 0 && headless)
+            frames = movie.endFrame();
+    }
+    else if(!record.empty())
+    {
+        movie.rom = romId;
+        movieInput = std::make_unique<GB_RECORDER>(gameboy.input, movie);
+        gameboy.input = movieInput.get();
+    }
+
+    if(frontend)
+        frontend->run(frames);
+    else if(frames >= 0)
+    {
+        while(!gameboy.quit && gameboy.frames < (uint64_t)frames)
+        {
+            if(!gameboy.runFrame())
+                break;
+        }
+    }
+    else
+	    gameboy.execute();
+    gameboy.mem.save();
+    if(!saveState.empty() && !gameboy.saveStateFile(saveState))
+        std::cout << "Could not save state " << saveState << std::endl;
+    if(!record.empty() && !movie.save(record))
+        std::cout << "Could not save movie " << record << std::endl;
+    return 0;
+}
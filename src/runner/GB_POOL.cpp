@@ -0,0 +1,102 @@
+#include "GB_POOL.h"
+
+thread_local int GB_POOL::current = -1;
+
+GB_POOL::GB_POOL(unsigned int threads) {
+    if(threads == 0)
+        threads = 1;
+
+    for(unsigned int i = 0; i < threads; i++)
+        queues.push_back(std::make_unique<queue>());
+    for(unsigned int i = 0; i < threads; i++)
+        workers.emplace_back(&GB_POOL::work, this, i);
+}
+
+GB_POOL::~GB_POOL() {
+    {
+        std::lock_guard<std::mutex> guard(idleLock);
+        stopping = true;
+    }
+    idle.notify_all();
+    for(std::thread& worker : workers)
+        worker.join();
+}
+
+void GB_POOL::submit(std::function<void()> task) {
+    int index = current != -1 ? current : nextQueue++ % queues.size();
+    pending++;
+    {
+        std::lock_guard<std::mutex> guard(queues[index]->lock);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+
+    //Taking the lock orders the increment before a worker deciding to sleep
+    {
+        std::lock_guard<std::mutex> guard(idleLock);
+        queued++;
+    }
+    idle.notify_one();
+}
+
+void GB_POOL::wait() {
+    std::unique_lock<std::mutex> guard(idleLock);
+    done.wait(guard, [this]() { return pending == 0; });
+}
+
+unsigned int GB_POOL::size() {
+    return workers.size();
+}
+
+void GB_POOL::work(int index) {
+    current = index;
+    std::function<void()> task;
+    while(true)
+    {
+        if(take(index, task))
+        {
+            task();
+            task = nullptr;
+            if(--pending == 0)
+            {
+                std::lock_guard<std::mutex> guard(idleLock);
+                done.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(idleLock);
+        idle.wait(guard, [this]() { return stopping || queued > 0; });
+        if(stopping && queued == 0)
+            return;
+    }
+}
+
+bool GB_POOL::take(int index, std::function<void()>& task) {
+    //Own queue first, newest task
+    {
+        queue& own = *queues[index];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if(!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+
+    //Then steal the oldest task of the others
+    for(size_t i = 1; i < queues.size(); i++)
+    {
+        queue& victim = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if(!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,179 @@
+#include "GB_RUNNER.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+bool GB_RUNNER::loadManifest(const std::string& fileName) {
+    std::ifstream manifest(fileName);
+    if(!manifest)
+    {
+        std::cout << "Could not open manifest " << fileName << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while(std::getline(manifest, line))
+    {
+        lineNumber++;
+        std::istringstream fields(line);
+        GB_INSTANCE instance;
+        if(!(fields >> instance.rom) || instance.rom[0] == '#')
+            continue;
+
+        if(!(fields >> instance.frameBudget))
+        {
+            std::cout << fileName << ":" << lineNumber << ": expected <rom> <frames> [input script]" << std::endl;
+            return false;
+        }
+        fields >> instance.inputScript;
+        instances.push_back(std::move(instance));
+    }
+    return true;
+}
+
+void GB_RUNNER::run(unsigned int threads) {
+    auto begin = std::chrono::steady_clock::now();
+    {
+        GB_POOL pool(threads);
+        for(GB_INSTANCE& instance : instances)
+            pool.submit([this, &pool, &instance]() { runSlice(pool, instance); });
+        pool.wait();
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void GB_RUNNER::runSlice(GB_POOL& pool, GB_INSTANCE& instance) {
+    auto begin = std::chrono::steady_clock::now();
+
+    //Instances are only built once a worker reaches them, so large batches don't hold every machine at once
+    if(instance.gameboy == nullptr && !start(instance))
+        return;
+
+    GB& gameboy = *instance.gameboy;
+    uint64_t end = std::min<uint64_t>(instance.frames + SLICE_FRAMES, instance.frameBudget);
+    while(instance.frames < end)
+    {
+        gameboy.runFrame();
+        instance.frames = gameboy.frames;
+    }
+    instance.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    if(instance.frames < instance.frameBudget)
+    {
+        pool.submit([this, &pool, &instance]() { runSlice(pool, instance); });
+        return;
+    }
+
+    uint64_t hash = 0xcbf29ce484222325;
+    const uint8_t* screen = gameboy.framebuffer();
+    for(size_t i = 0; i < sizeof(gameboy.gpu.screen); i++)
+        hash = (hash ^ screen[i]) * 0x100000001b3;
+    instance.screenHash = hash;
+    instance.gameboy.reset();
+    instance.player.reset();
+}
+
+bool GB_RUNNER::start(GB_INSTANCE& instance) {
+    std::ifstream file(instance.rom, std::ios::binary);
+    if(!file)
+    {
+        instance.error = "could not open rom";
+        return false;
+    }
+    std::vector<unsigned char> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if(!instance.inputScript.empty() && !loadInputs(instance))
+        return false;
+
+    //Instances sharing a cartridge would all read and write the same .sav, so battery ram starts empty
+    instance.gameboy = std::make_unique<GB>(std::move(rom), false);
+    if(!instance.gameboy->loaded)
+    {
+        instance.gameboy.reset();
+        instance.error = "not a gameboy rom";
+        return false;
+    }
+    instance.player = std::make_unique<GB_PLAYER>(instance.movie);
+    instance.gameboy->input = instance.player.get();
+    return true;
+}
+
+//Reads a whole decimal, hex or octal token no larger than max
+static bool parseNumber(const std::string& token, uint64_t max, uint64_t& value) {
+    if(token.empty() || token[0] == '-')
+        return false;
+    char* end;
+    errno = 0;
+    unsigned long long parsed = std::strtoull(token.c_str(), &end, 0);
+    if(errno != 0 || *end != '\0' || parsed > max)
+        return false;
+    value = parsed;
+    return true;
+}
+
+bool GB_RUNNER::loadInputs(GB_INSTANCE& instance) {
+    if(instance.movie.load(instance.inputScript))
+        return true;
+
+    std::ifstream script(instance.inputScript);
+    if(!script)
+    {
+        instance.error = "could not open input script";
+        return false;
+    }
+
+    //Buttons held from each listed frame on
+    std::map<uint64_t, uint8_t> changes;
+    std::string line;
+    while(std::getline(script, line))
+    {
+        std::istringstream fields(line);
+        std::string frame, buttons;
+        if(!(fields >> frame) || frame[0] == '#')
+            continue;
+        uint64_t frameNumber, mask;
+        if(!(fields >> buttons) || !parseNumber(frame, UINT64_MAX, frameNumber) || !parseNumber(buttons, 0xFF, mask))
+        {
+            instance.error = "bad input script line: " + line;
+            return false;
+        }
+        changes[frameNumber] = mask;
+    }
+
+    uint8_t held = 0;
+    auto change = changes.begin();
+    for(uint64_t frame = 0; frame <= instance.frameBudget; frame++)
+    {
+        for(; change != changes.end() && change->first <= frame; change++)
+            held = change->second;
+        instance.movie.buttons.push_back(held);
+    }
+    instance.movie.startFrame = 0;
+    return true;
+}
+
+void GB_RUNNER::report(std::ostream& out) {
+    uint64_t totalFrames = 0;
+    for(size_t i = 0; i < instances.size(); i++)
+    {
+        GB_INSTANCE& instance = instances[i];
+        totalFrames += instance.frames;
+
+        out << std::dec << i << " " << instance.rom << ": ";
+        if(!instance.error.empty())
+        {
+            out << "error, " << instance.error << "\n";
+            continue;
+        }
+        out << instance.frames << "/" << instance.frameBudget << " frames";
+        out << ", " << std::fixed << std::setprecision(3) << instance.seconds << " s";
+        out << ", " << std::setprecision(1) << (instance.seconds > 0 ? instance.frames / instance.seconds : 0) << " fps";
+        out << ", screen " << std::hex << std::setw(16) << std::setfill('0') << instance.screenHash << std::setfill(' ') << std::dec << "\n";
+    }
+
+    out << instances.size() << " instances, " << totalFrames << " frames in " << std::fixed << std::setprecision(3) << seconds << " s, ";
+    out << std::setprecision(1) << (seconds > 0 ? totalFrames / seconds : 0) << " fps aggregate" << std::endl;
+}
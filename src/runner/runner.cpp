@@ -0,0 +1,29 @@
+#include "GB_RUNNER.h"
+#include <cstring>
+
+int main(int argc, char* argv[])
+{
+    //ggboy_runner [--threads n] manifest
+    unsigned int threads = std::thread::hardware_concurrency();
+    std::string manifest;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else
+            manifest = argv[i];
+    }
+
+    if(manifest.empty())
+    {
+        std::cout << "Usage: ggboy_runner [--threads n] manifest" << std::endl;
+        return 1;
+    }
+
+    GB_RUNNER runner;
+    if(!runner.loadManifest(manifest))
+        return 1;
+    runner.run(threads);
+    runner.report(std::cout);
+    return 0;
+}